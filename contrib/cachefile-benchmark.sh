@@ -0,0 +1,26 @@
+#!/usr/bin/env sh
+# Compare a full scan of the eix cachefile when reading with mmap
+# and when reading with stdio (MMAP_CACHEFILE=false).
+# Usage: cachefile-benchmark.sh [samples] [eix-binary] [eix-args...]
+#
+# This file is part of the eix project and distributed under the
+# terms of the GNU General Public License v2.
+#
+# Copyright (c)
+#   agent <agent@local>
+
+set -u
+
+samples=${1:-10}
+[ $# -gt 0 ] && shift
+eix=${1:-eix}
+[ $# -gt 0 ] && shift
+[ $# -gt 0 ] || set -- -c ''
+
+bench=${0%/*}/simple-benchmark.sh
+
+for mmap in true false
+do	printf '%s\n' ">>> MMAP_CACHEFILE=$mmap $eix $*"
+	MMAP_CACHEFILE=$mmap bash "$bench" "$samples" "$eix" "$@" | \
+		grep -e '-- average'
+done
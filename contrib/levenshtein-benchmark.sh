@@ -0,0 +1,27 @@
+#!/usr/bin/env sh
+# Compare the speed of fuzzy searches (which compute a Levenshtein distance
+# for every package name) of two eix binaries, e.g. before and after a change.
+# Usage: levenshtein-benchmark.sh [samples] [old-eix] [new-eix] [eix-args...]
+#
+# This file is part of the eix project and distributed under the
+# terms of the GNU General Public License v2.
+#
+# Copyright (c)
+#   agent <agent@local>
+
+set -u
+
+samples=${1:-10}
+[ $# -gt 0 ] && shift
+old=${1:-eix}
+[ $# -gt 0 ] && shift
+new=${1:-eix}
+[ $# -gt 0 ] && shift
+[ $# -gt 0 ] || set -- -f 3 -c libreoffice-bin
+
+bench=${0%/*}/simple-benchmark.sh
+
+for eix in "$old" "$new"
+do	printf '%s\n' ">>> $eix $*"
+	bash "$bench" "$samples" "$eix" "$@" | grep -e '-- average'
+done
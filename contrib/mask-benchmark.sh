@@ -0,0 +1,66 @@
+#!/usr/bin/env sh
+# Compare the speed of two eix binaries when applying huge package.mask,
+# package.unmask, and package.accept_keywords files (with many wildcard
+# entries) to all packages of the cachefile.
+# The files are generated from the package names in a temporary
+# PORTAGE_CONFIGROOT which uses make.conf and make.profile of the current one.
+# Usage: mask-benchmark.sh [lines] [samples] [old-eix] [new-eix] [eix-args...]
+#
+# This file is part of the eix project and distributed under the
+# terms of the GNU General Public License v2.
+#
+# Copyright (c)
+#   agent <agent@local>
+
+set -u
+
+lines=${1:-10000}
+[ $# -gt 0 ] && shift
+samples=${1:-10}
+[ $# -gt 0 ] && shift
+old=${1:-eix}
+[ $# -gt 0 ] && shift
+new=${1:-eix}
+[ $# -gt 0 ] && shift
+[ $# -gt 0 ] || set -- --non-masked
+
+bench=$(cd -- "${0%/*}" && pwd)/simple-benchmark.sh
+root=${PORTAGE_CONFIGROOT:-}/etc/portage
+
+tmp=$(mktemp -d) || exit
+trap 'rm -rf -- "$tmp"' EXIT
+trap 'exit 130' INT TERM
+mkdir -p -- "$tmp/etc/portage" || exit
+for i in make.conf make.profile
+do	[ -e "$root/$i" ] && ln -s -- "$(readlink -f -- "$root/$i")" \
+		"$tmp/etc/portage/$i"
+done
+
+# Cycle through the kinds of entries: exact names, category and name
+# wildcards, and the version and slot restrictions of portage
+EIX_LIMIT=0 "$old" --only-names | awk -v lines="$lines" -v dir="$tmp/etc/portage" '
+{ split($0, a, "/"); cat[NR] = a[1]; name[NR] = a[2] }
+END {
+	if(NR == 0) exit 1
+	for(i = 0; i < lines; ++i) {
+		j = i % NR + 1; c = cat[j]; n = name[j]
+		k = i % 8
+		if(k == 0) e = c "/" n
+		else if(k == 1) e = c "/" substr(n, 1, 2) "*"
+		else if(k == 2) e = "*/" n
+		else if(k == 3) e = "*/*" substr(n, length(n) - 1)
+		else if(k == 4) e = substr(c, 1, 4) "*/" n
+		else if(k == 5) e = "=" c "/" n "-" (i % 3) "*"
+		else if(k == 6) e = c "/" substr(n, 1, 1) "?" substr(n, 3)
+		else e = c "/*:" (i % 3)
+		print e > (dir "/package.mask")
+		if(i % 2) print e > (dir "/package.unmask")
+		print e " ~amd64 ~x86" > (dir "/package.accept_keywords")
+	}
+}' || exit
+
+for eix in "$old" "$new"
+do	printf '%s\n' ">>> $eix $*"
+	PORTAGE_CONFIGROOT=$tmp EIX_LIMIT=0 bash "$bench" "$samples" "$eix" "$@" \
+		| grep -e '-- average'
+done
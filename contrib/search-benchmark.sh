@@ -0,0 +1,36 @@
+#!/usr/bin/env sh
+# Compare the speed of description searches (which match every package
+# description of the cachefile) of two eix binaries, e.g. before and after
+# a change. Case-insensitive substrings, case-sensitive substrings, and
+# proper regular expressions are timed separately.
+# With a cachefile written with SAVE_TRIGRAMS=false, every description
+# is actually matched; otherwise the trigram index filters them first.
+# Usage: search-benchmark.sh [samples] [old-eix] [new-eix] [words...]
+#
+# This file is part of the eix project and distributed under the
+# terms of the GNU General Public License v2.
+#
+# Copyright (c)
+#   agent <agent@local>
+
+set -u
+
+samples=${1:-10}
+[ $# -gt 0 ] && shift
+old=${1:-eix}
+[ $# -gt 0 ] && shift
+new=${1:-eix}
+[ $# -gt 0 ] && shift
+[ $# -gt 0 ] || set -- library xyzzy
+
+bench=${0%/*}/simple-benchmark.sh
+
+for word
+do	for args in "-S --regex $word" "-S --substring $word" "-S --regex ^$word.*s"
+	do	for eix in "$old" "$new"
+		do	printf '%s\n' ">>> $eix $args"
+			EIX_LIMIT=0 bash "$bench" "$samples" "$eix" $args \
+				| grep -e '-- average'
+		done
+	done
+done
@@ -15,6 +15,7 @@
 #include <string>
 
 #include "eixTk/attribute.h"
+#include "eixTk/eixint.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
@@ -24,6 +25,8 @@
 
 using std::string;
 
+eix::UNumber BasicCache::files_read = 0, BasicCache::bytes_read = 0;
+
 ATTRIBUTE_PURE inline static string::size_type revision_index(const string& ver) {
 	string::size_type i(ver.rfind("-r"));
 	if(i == string::npos) {
@@ -18,6 +18,7 @@
 
 #include "eixTk/attribute.h"
 #include "eixTk/diagnostics.h"
+#include "eixTk/eixint.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/sysutils.h"
@@ -41,6 +42,11 @@ class BasicCache {
 	public:
 		typedef void (*ErrorCallback)(const std::string& str);
 
+		/**
+		Statistics: Number of cache files and bytes read by all caches
+		**/
+		static eix::UNumber files_read, bytes_read;
+
 		BasicCache() {
 			portagesettings = NULLPTR;
 		}
@@ -80,6 +86,12 @@ class BasicCache {
 		virtual void setVerbose() {
 		}
 
+		/**
+		Let the cache prefetch the files of a category before reading them
+		**/
+		virtual void setPrefetch() {
+		}
+
 		/**
 		Get overlay-key
 		**/
@@ -175,6 +187,16 @@ class BasicCache {
 			m_catname.clear();
 		}
 
+		/**
+		Get a stamp of the category for incremental updates:
+		If the stamp has not changed, the data of the category in the
+		cache are assumed to be unchanged.
+		@return false if the cache does not support stamps
+		**/
+		ATTRIBUTE_NONNULL_ virtual bool get_category_stamp(std::string * /* stamp */, const char * /* cat_name */) {
+			return false;
+		}
+
 		ATTRIBUTE_NONNULL_ virtual bool get_time(std::time_t * /* time */, const std::string & /* pkg_name */, const std::string & /* ver_name */) const {
 			return 0;
 		}
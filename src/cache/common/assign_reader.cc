@@ -10,19 +10,23 @@
 #include "cache/common/assign_reader.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <cerrno>
 #include <cstring>
 #include <ctime>
 
-#include <fstream>
 #include <string>
+#include <vector>
 
 #include "cache/base.h"
+#include "cache/common/reader.h"
+#include "eixTk/attribute.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
-#include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "portage/depend.h"
 #include "portage/package.h"
@@ -30,35 +34,174 @@
 
 using std::string;
 
-using std::ifstream;
+/**
+Is the key of length len equal to name?
+**/
+ATTRIBUTE_NONNULL_ inline static bool key_is(const char *key, string::size_type len, const char *name) {
+	return ((std::strlen(name) == len) && (std::memcmp(key, name, len) == 0));
+}
 
-bool AssignReader::get_map(const string &file) {
-	if(currfile == NULLPTR) {
-		currfile = new string(file);
-		cf = new WordUnorderedMap;
-	} else {
-		if(*currfile == file) {
-			return currstate;
-		}
-		currfile->assign(file);
-		cf->clear();
+AssignReader::Key AssignReader::find_key(const char *key, string::size_type len) {
+	switch(*key) {
+		case 'B':
+			if(key_is(key, len, "BDEPEND")) {
+				return KEY_BDEPEND;
+			}
+			break;
+		case 'D':
+			if(key_is(key, len, "DEPEND")) {
+				return KEY_DEPEND;
+			}
+			if(key_is(key, len, "DESCRIPTION")) {
+				return KEY_DESCRIPTION;
+			}
+			break;
+		case 'E':
+			if(key_is(key, len, "EAPI")) {
+				return KEY_EAPI;
+			}
+			break;
+		case 'H':
+			if(key_is(key, len, "HOMEPAGE")) {
+				return KEY_HOMEPAGE;
+			}
+			break;
+		case 'I':
+			if(key_is(key, len, "IUSE")) {
+				return KEY_IUSE;
+			}
+			if(key_is(key, len, "IDEPEND")) {
+				return KEY_IDEPEND;
+			}
+			break;
+		case 'K':
+			if(key_is(key, len, "KEYWORDS")) {
+				return KEY_KEYWORDS;
+			}
+			break;
+		case 'L':
+			if(key_is(key, len, "LICENSE")) {
+				return KEY_LICENSE;
+			}
+			break;
+		case 'P':
+			if(key_is(key, len, "PDEPEND")) {
+				return KEY_PDEPEND;
+			}
+			if(key_is(key, len, "PROPERTIES")) {
+				return KEY_PROPERTIES;
+			}
+			break;
+		case 'R':
+			if(key_is(key, len, "RDEPEND")) {
+				return KEY_RDEPEND;
+			}
+			if(key_is(key, len, "RESTRICT")) {
+				return KEY_RESTRICT;
+			}
+			if(key_is(key, len, "REQUIRED_USE")) {
+				return KEY_REQUIRED_USE;
+			}
+			break;
+		case 'S':
+			if(key_is(key, len, "SLOT")) {
+				return KEY_SLOT;
+			}
+			if(key_is(key, len, "SRC_URI")) {
+				return KEY_SRC_URI;
+			}
+			break;
+		case '_':
+			if(key_is(key, len, "_md5_")) {
+				return KEY_MD5;
+			}
+			if(key_is(key, len, "_mtime_")) {
+				return KEY_MTIME;
+			}
+			break;
+		default:
+			break;
 	}
+	return KEY_NONE;
+}
 
-	ifstream is(file.c_str());
-	if(unlikely(!is.is_open())) {
-		return (currstate = false);
+/**
+Read file with a single read() call (usually) into the reused buffer
+**/
+bool AssignReader::read_buffer(const string &file) {
+	int fd(open(file.c_str(), O_RDONLY));
+	if(unlikely(fd == -1)) {
+		return false;
 	}
-
-	while(likely(is.good())) {
-		string lbuf;
-		getline(is, lbuf);
-		string::size_type p(lbuf.find('='));
-		if(p == string::npos) {
+	if(unlikely(buffer.empty())) {
+		buffer.resize(8192);
+	}
+	std::vector<char>::size_type len(0);
+	for(;;) {
+		// Keep space for the terminating '\0'
+		if(unlikely(buffer.size() - len < 2)) {
+			buffer.resize(2 * buffer.size());
+		}
+		ssize_t r(read(fd, &(buffer[len]), buffer.size() - len - 1));
+		if(likely(r > 0)) {
+			len += static_cast<std::vector<char>::size_type>(r);
 			continue;
 		}
-		(*cf)[lbuf.substr(0, p)].assign(lbuf, p + 1, string::npos);
+		if(likely(r == 0)) {
+			break;
+		}
+		if(errno != EINTR) {
+			int saved_errno(errno);
+			close(fd);
+			errno = saved_errno;
+			return false;
+		}
 	}
-	is.close();
+	close(fd);
+	buffer[len] = '\0';
+	count_file(len);
+	return true;
+}
+
+/**
+Store pointers to the values of the known keys of the lines in buffer
+**/
+void AssignReader::parse_buffer() {
+	for(int i(0); likely(i != KEY_COUNT); ++i) {
+		value[i] = NULLPTR;
+	}
+	for(char *line(&(buffer[0])); likely(*line != '\0'); ) {
+		char *end(std::strchr(line, '\n'));
+		char *next;
+		if(likely(end != NULLPTR)) {
+			*end = '\0';
+			next = end + 1;
+		} else {
+			end = line + std::strlen(line);
+			next = end;
+		}
+		const char *eq(static_cast<const char *>(std::memchr(line, '=', static_cast<string::size_type>(end - line))));
+		if(likely(eq != NULLPTR)) {
+			Key key(find_key(line, static_cast<string::size_type>(eq - line)));
+			if(key != KEY_NONE) {
+				value[key] = eq + 1;
+				length[key] = static_cast<string::size_type>(end - eq - 1);
+			}
+		}
+		line = next;
+	}
+}
+
+bool AssignReader::get_map(const string &file) {
+	if(have_file && (currfile == file)) {
+		return currstate;
+	}
+	have_file = true;
+	currfile.assign(file);
+	if(unlikely(!read_buffer(file))) {
+		return (currstate = false);
+	}
+	parse_buffer();
 	return (currstate = true);
 }
 
@@ -66,49 +209,55 @@ const char *AssignReader::get_md5sum(const string &filename) {
 	if(unlikely(!get_map(filename))) {
 		return NULLPTR;
 	}
-	WordUnorderedMap::const_iterator md5(cf->find("_md5_"));
-	if(md5 == cf->end()) {
-		return NULLPTR;
-	}
-	return md5->second.c_str();
+	return value[KEY_MD5];
 }
 
 bool AssignReader::get_mtime(std::time_t *t, const string &filename) {
 	if(unlikely(!get_map(filename))) {
 		return false;
 	}
-	WordUnorderedMap::const_iterator mt(cf->find("_mtime_"));
-	if(mt == cf->end()) {
+	const char *mt(value[KEY_MTIME]);
+	if(mt == NULLPTR) {
 		return false;
 	}
-	return likely(((*t) = my_atos(mt->second.c_str())) != 0);
+	return likely(((*t) = my_atos(mt)) != 0);
 }
 
 /**
-Read stability and other data from an "assign type" cache file
+Read stability, the common data, and other data from an "assign type" cache file
 **/
 void AssignReader::get_keywords_slot_iuse_restrict(const string& filename, string *eapi, string *keywords,
 	string *slotname, string *iuse, string *required_use, string *restr,
-	string *props, Depend *dep, string *src_uri) {
+	string *props, Depend *dep, string *src_uri, CommonInfo *common) {
 	if(unlikely(!get_map(filename))) {
 		m_cache->m_error_callback(eix::format(_("cannot read cache file %s: %s"))
 			% filename % std::strerror(errno));
 		return;
 	}
-	(*eapi)     = (*cf)["EAPI"];
-	(*keywords) = (*cf)["KEYWORDS"];
-	(*slotname) = (*cf)["SLOT"];
-	(*iuse)     = (*cf)["IUSE"];
-	(*restr)    = (*cf)["RESTRICT"];
-	(*props)    = (*cf)["PROPERTIES"];
+	get_value(eapi, KEY_EAPI);
+	get_value(keywords, KEY_KEYWORDS);
+	get_value(slotname, KEY_SLOT);
+	get_value(iuse, KEY_IUSE);
+	get_value(restr, KEY_RESTRICT);
+	get_value(props, KEY_PROPERTIES);
+	get_value(&(common->homepage), KEY_HOMEPAGE);
+	get_value(&(common->licenses), KEY_LICENSE);
+	get_value(&(common->desc), KEY_DESCRIPTION);
+	common->valid = true;
 	if(Version::use_required_use) {
-		(*required_use) = (*cf)["REQUIRED_USE"];
+		get_value(required_use, KEY_REQUIRED_USE);
 	}
 	if(Depend::use_depend) {
-		dep->set((*cf)["DEPEND"], (*cf)["RDEPEND"], (*cf)["PDEPEND"], (*cf)["BDEPEND"], (*cf)["IDEPEND"], false);
+		string depend, rdepend, pdepend, bdepend, idepend;
+		get_value(&depend, KEY_DEPEND);
+		get_value(&rdepend, KEY_RDEPEND);
+		get_value(&pdepend, KEY_PDEPEND);
+		get_value(&bdepend, KEY_BDEPEND);
+		get_value(&idepend, KEY_IDEPEND);
+		dep->set(depend, rdepend, pdepend, bdepend, idepend, false);
 	}
 	if(ExtendedVersion::use_src_uri) {
-		(*src_uri) = (*cf)["SRC_URI"];
+		get_value(src_uri, KEY_SRC_URI);
 	}
 }
 
@@ -121,7 +270,7 @@ void AssignReader::read_file(const string& filename, Package *pkg) {
 			% filename % std::strerror(errno));
 		return;
 	}
-	pkg->homepage = (*cf)["HOMEPAGE"];
-	pkg->licenses = (*cf)["LICENSE"];
-	pkg->desc     = (*cf)["DESCRIPTION"];
+	get_value(&(pkg->homepage), KEY_HOMEPAGE);
+	get_value(&(pkg->licenses), KEY_LICENSE);
+	get_value(&(pkg->desc), KEY_DESCRIPTION);
 }
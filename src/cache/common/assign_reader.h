@@ -15,42 +15,89 @@
 #include <ctime>
 
 #include <string>
+#include <vector>
 
 #include "cache/common/reader.h"
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
-#include "eixTk/likely.h"
 #include "eixTk/null.h"
-#include "eixTk/stringtypes.h"
 
 class BasicCache;
+class CommonInfo;
 class Depend;
 class Package;
 
 class AssignReader : public BasicReader {
 	public:
 		explicit AssignReader(BasicCache *cache) :
-			BasicReader(cache), currfile(NULLPTR) {
-		}
-
-		~AssignReader() {
-			if(likely(currfile != NULLPTR)) {
-				delete currfile;
-				delete cf;
-			}
+			BasicReader(cache), have_file(false), currstate(false) {
 		}
 
 		ATTRIBUTE_NONNULL_ const char *get_md5sum(const std::string &filename) OVERRIDE;
 		ATTRIBUTE_NONNULL_ bool get_mtime(std::time_t *t, const std::string &filename) OVERRIDE;
-		ATTRIBUTE_NONNULL_ void get_keywords_slot_iuse_restrict(const std::string& filename, std::string *eapi, std::string *keywords, std::string *slotname, std::string *iuse, std::string *required_use, std::string *restr, std::string *props, Depend *dep, std::string *src_uri) OVERRIDE;
+		ATTRIBUTE_NONNULL_ void get_keywords_slot_iuse_restrict(const std::string& filename, std::string *eapi, std::string *keywords, std::string *slotname, std::string *iuse, std::string *required_use, std::string *restr, std::string *props, Depend *dep, std::string *src_uri, CommonInfo *common) OVERRIDE;
 		ATTRIBUTE_NONNULL_ void read_file(const std::string& filename, Package *pkg) OVERRIDE;
 
 	private:
+		/**
+		The keys of the cache file which are used; others are ignored
+		**/
+		enum Key {
+			KEY_EAPI,
+			KEY_KEYWORDS,
+			KEY_SLOT,
+			KEY_IUSE,
+			KEY_REQUIRED_USE,
+			KEY_RESTRICT,
+			KEY_PROPERTIES,
+			KEY_DEPEND,
+			KEY_RDEPEND,
+			KEY_PDEPEND,
+			KEY_BDEPEND,
+			KEY_IDEPEND,
+			KEY_SRC_URI,
+			KEY_HOMEPAGE,
+			KEY_LICENSE,
+			KEY_DESCRIPTION,
+			KEY_MD5,
+			KEY_MTIME,
+			KEY_COUNT,
+			KEY_NONE = KEY_COUNT
+		};
+
+		ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE static Key find_key(const char *key, std::string::size_type len);
+
 		ATTRIBUTE_NONNULL_ bool get_map(const std::string &file);
 
-		std::string *currfile;
-		WordUnorderedMap *cf;
-		bool currstate;
+		ATTRIBUTE_NONNULL_ bool read_buffer(const std::string &file);
+
+		void parse_buffer();
+
+		/**
+		Assign the value of key (or the empty string) to s
+		**/
+		ATTRIBUTE_NONNULL_ void get_value(std::string *s, Key key) const {
+			if(value[key] == NULLPTR) {
+				s->clear();
+			} else {
+				s->assign(value[key], length[key]);
+			}
+		}
+
+		std::string currfile;
+		bool have_file, currstate;
+
+		/**
+		The content of currfile; it is reused for each file. The newlines are
+		replaced by '\0' so that each value is a C string within the buffer.
+		**/
+		std::vector<char> buffer;
+
+		/**
+		Pointers to the values in buffer (or NULLPTR) and their lengths
+		**/
+		const char *value[KEY_COUNT];
+		std::string::size_type length[KEY_COUNT];
 };
 
 #endif  // SRC_CACHE_COMMON_ASSIGN_READER_H_
@@ -18,6 +18,7 @@
 #include <string>
 
 #include "cache/base.h"
+#include "cache/common/reader.h"
 #include "eixTk/eixint.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
@@ -43,9 +44,9 @@ bool FlatReader::skip_lines(const eix::TinyUnsigned nr, ifstream *is, const stri
 }
 
 /**
-Read the keywords and slot from a flat cache file
+Read the keywords, slot, and the common data from a flat cache file
 **/
-void FlatReader::get_keywords_slot_iuse_restrict(const string& filename, string *eapi, string *keywords, string *slotname, string *iuse, string *required_use, string *restr, string *props, Depend *dep, string *src_uri) {
+void FlatReader::get_keywords_slot_iuse_restrict(const string& filename, string *eapi, string *keywords, string *slotname, string *iuse, string *required_use, string *restr, string *props, Depend *dep, string *src_uri, CommonInfo *common) {
 	ifstream is(filename.c_str());
 	if(!is.is_open()) {
 		m_cache->m_error_callback(eix::format(_("cannot open %s: %s"))
@@ -66,7 +67,10 @@ void FlatReader::get_keywords_slot_iuse_restrict(const string& filename, string
 		skip_lines(1, &is, filename);
 	}
 	getline(is, *restr);
-	skip_lines(3, &is, filename);
+	getline(is, common->homepage);
+	getline(is, common->licenses);
+	getline(is, common->desc);
+	common->valid = !is.fail();
 	getline(is, *keywords);
 	if(use_dep) {
 		getline(is, idepend);
@@ -91,6 +95,7 @@ void FlatReader::get_keywords_slot_iuse_restrict(const string& filename, string
 	}
 	getline(is, *eapi);
 	getline(is, *props);
+	count_file(&is);
 	is.close();
 }
 
@@ -114,6 +119,7 @@ void FlatReader::read_file(const string& filename, Package *pkg) {
 			case 6:  pkg->licenses = linebuf;
 			         break;
 			case 7:  pkg->desc     = linebuf;
+			         count_file(&is);
 			         is.close();
 			         return;
 			default:
@@ -121,5 +127,6 @@ void FlatReader::read_file(const string& filename, Package *pkg) {
 		}
 	}
 	// We should never get here. However, we do not spit errors if we do...
+	count_file(&is);
 	is.close();
 }
@@ -21,6 +21,7 @@
 #include "eixTk/eixint.h"
 
 class BasicCache;
+class CommonInfo;
 class Depend;
 class Package;
 
@@ -29,7 +30,7 @@ class FlatReader : public BasicReader {
 		explicit FlatReader(BasicCache *cache) : BasicReader(cache) {
 		}
 
-		ATTRIBUTE_NONNULL_ void get_keywords_slot_iuse_restrict(const std::string& filename, std::string *eapi, std::string *keywords, std::string *slotname, std::string *iuse, std::string *required_use, std::string *restr, std::string *props, Depend *dep, std::string *src_uri) OVERRIDE;
+		ATTRIBUTE_NONNULL_ void get_keywords_slot_iuse_restrict(const std::string& filename, std::string *eapi, std::string *keywords, std::string *slotname, std::string *iuse, std::string *required_use, std::string *restr, std::string *props, Depend *dep, std::string *src_uri, CommonInfo *common) OVERRIDE;
 		ATTRIBUTE_NONNULL_ void read_file(const std::string& filename, Package *pkg) OVERRIDE;
 
 	private:
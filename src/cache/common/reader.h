@@ -12,16 +12,36 @@
 
 #include <ctime>
 
+#include <fstream>
 #include <string>
 
 #include "cache/base.h"
 #include "eixTk/attribute.h"
+#include "eixTk/eixint.h"
+#include "eixTk/likely.h"
 #include "eixTk/null.h"
 
 class BasicCache;
 class Depend;
 class Package;
 
+/**
+The data of a cache file which belongs to the package and not to the version.
+It is read together with the version data so that each file is read only once.
+**/
+class CommonInfo {
+	public:
+		std::string homepage, licenses, desc;
+
+		/**
+		false if the data could not be read
+		**/
+		bool valid;
+
+		CommonInfo() : valid(false) {
+		}
+};
+
 /**
 Parent class of all readers
 **/
@@ -44,10 +64,29 @@ class BasicReader {
 			return false;
 		}
 
-		ATTRIBUTE_NONNULL_ virtual void get_keywords_slot_iuse_restrict(const std::string& filename, std::string *eapi, std::string *keywords, std::string *slotname, std::string *iuse, std::string *required_use, std::string *restr, std::string *props, Depend *dep, std::string *src_uri) = 0;
+		ATTRIBUTE_NONNULL_ virtual void get_keywords_slot_iuse_restrict(const std::string& filename, std::string *eapi, std::string *keywords, std::string *slotname, std::string *iuse, std::string *required_use, std::string *restr, std::string *props, Depend *dep, std::string *src_uri, CommonInfo *common) = 0;
 
 		ATTRIBUTE_NONNULL_ virtual void read_file(const std::string& filename, Package *pkg) = 0;
 
+	protected:
+		/**
+		Count it in the statistics of BasicCache, assuming that it has
+		been read up to the current position (or to the end)
+		**/
+		ATTRIBUTE_NONNULL_ static void count_file(std::ifstream *is) {
+			if(unlikely(!is->is_open())) {
+				return;
+			}
+			is->clear();
+			std::streamoff pos(is->tellg());
+			count_file(likely(pos > 0) ? static_cast<eix::UNumber>(pos) : 0);
+		}
+
+		static void count_file(eix::UNumber bytes) {
+			++(BasicCache::files_read);
+			BasicCache::bytes_read += bytes;
+		}
+
 	public:
 		BasicCache *m_cache;
 };
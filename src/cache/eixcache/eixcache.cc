@@ -178,7 +178,7 @@ void EixCache::get_package(Package *p) {
 		Version *version(new Version);
 		*static_cast<BasicVersion *>(version) = *static_cast<BasicVersion *>(*it);
 		version->overlay_key = m_overlay_key;
-		version->set_full_keywords(it->get_full_keywords());
+		version->set_full_keyword_ids(it->get_full_keyword_ids());
 		version->slotname = it->slotname;
 		version->subslotname = it->subslotname;
 		version->restrictFlags = it->restrictFlags;
@@ -263,6 +263,12 @@ bool EixCache::readCategories(PackageTree *packagetree, const char *cat_name, Ca
 	}
 
 	PackageReader reader(&db, header);
+	if(packagetree == NULLPTR) {
+		// Only one category is needed
+		PackageReader::Pins pins;
+		pins.PUSH_BACK(PackageReader::Pin(cat_name, string()));
+		reader.restrict_to(pins);
+	}
 	for(; reader.next(); reader.skip()) {
 		if(unlikely(!reader.read(PackageReader::NAME))) {
 			break;
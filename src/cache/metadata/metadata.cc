@@ -11,6 +11,7 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <dirent.h>
+#include <sys/stat.h>
 
 #include <cstring>
 #include <ctime>
@@ -20,12 +21,14 @@
 #include "cache/common/assign_reader.h"
 #include "cache/common/flat_reader.h"
 #include "cache/common/reader.h"
+#include "eixTk/eixint.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/sysutils.h"
 #include "eixTk/utils.h"
 #include "portage/basicversion.h"
 #include "portage/extendedversion.h"
@@ -260,6 +263,35 @@ void MetadataCache::readCategoryFinalize() {
 	m_catpath.clear();
 	names.clear();
 }
+/**
+The stamp consists of the mtime of the directory, the number of files,
+and the sums of their mtimes and sizes
+**/
+bool MetadataCache::get_category_stamp(string *stamp, const char *cat_name) {
+	struct stat st;
+	if(!readCategoryPrepare(cat_name) || (stat(m_catpath.c_str(), &st) != 0)) {
+		stamp->clear();
+		readCategoryFinalize();
+		return true;
+	}
+	std::time_t dir_mtime(st.st_mtime), mtimes(0);
+	eix::OffsetType sizes(0);
+	string path(m_catpath);
+	path.append(1, '/');
+	string::size_type len(path.size());
+	for(WordVec::const_iterator it(names.begin()); likely(it != names.end()); ++it) {
+		path.erase(len);
+		path.append(*it);
+		if(likely(stat(path.c_str(), &st) == 0)) {
+			mtimes += st.st_mtime;
+			sizes += st.st_size;
+		}
+	}
+	*stamp = eix::format("%s %s %s %s") % dir_mtime % names.size() % mtimes % sizes;
+	readCategoryFinalize();
+	return true;
+}
+
 const char *MetadataCache::get_md5sum(const string &pkg_name, const string &ver_name) const {
 	return (reader->get_md5sum)(m_catpath + "/" + pkg_name + "-" + ver_name);
 }
@@ -269,13 +301,22 @@ bool MetadataCache::get_time(std::time_t *t, const string &pkg_name, const strin
 }
 
 void MetadataCache::get_version_info(const string &pkg_name, const string &ver_name, Version *version) const {
+	CommonInfo common;
+	get_version_info(pkg_name, ver_name, version, &common);
+}
+
+/**
+Read the data of the version and store the data of the package in common
+so that the cache file need not be read a second time
+**/
+void MetadataCache::get_version_info(const string &pkg_name, const string &ver_name, Version *version, CommonInfo *common) const {
 	string eapi, keywords, iuse, required_use, restr, props, slot;
 	string path(m_catpath);
 	path.append(1, '/');
 	path.append(pkg_name);
 	path.append(1, '-');
 	path.append(ver_name);
-	(reader->get_keywords_slot_iuse_restrict)(path, &eapi, &keywords, &slot, &iuse, &required_use, &restr, &props, &(version->depend), &(version->src_uri));
+	(reader->get_keywords_slot_iuse_restrict)(path, &eapi, &keywords, &slot, &iuse, &required_use, &restr, &props, &(version->depend), &(version->src_uri), common);
 	version->eapi.assign(eapi);
 	version->set_slotname(slot);
 	version->set_full_keywords(keywords);
@@ -291,10 +332,22 @@ void MetadataCache::get_common_info(const string &pkg_name, const string &ver_na
 }
 
 bool MetadataCache::readCategory(Category *cat) {
+	if(prefetch) {
+		// Let the kernel read all files in parallel while we parse
+		string path(m_catpath);
+		path.append(1, '/');
+		string::size_type len(path.size());
+		for(WordVec::const_iterator it(names.begin());
+			likely(it != names.end()); ++it) {
+			path.erase(len);
+			path.append(*it);
+			prefetch_file(path.c_str());
+		}
+	}
 	for(WordVec::const_iterator it(names.begin());
 		likely(it != names.end()); ) {
 		Version *newest(NULLPTR);
-		string neweststring;
+		CommonInfo newest_info;
 
 		/* Split string into package and version, and catch any errors. */
 		string curr_name, curr_version;
@@ -323,16 +376,20 @@ bool MetadataCache::readCategory(Category *cat) {
 			if(unlikely(r == BasicVersion::parsedError)) {
 				delete version;
 			} else {
-				get_version_info(curr_name, curr_version, version);
+				CommonInfo info;
+				get_version_info(curr_name, curr_version, version, &info);
 
 				pkg->addVersion(version);
 				if(*(pkg->latest()) == *version) {
 					newest = version;
-					neweststring = curr_version;
+					newest_info.valid = info.valid;
+					newest_info.homepage.swap(info.homepage);
+					newest_info.licenses.swap(info.licenses);
+					newest_info.desc.swap(info.desc);
 				}
 			}
 
-			/* If this is the last file we break so we can get the full
+			/* If this is the last file we break so we can store the full
 			 * information after this while-loop. If we still have more files
 			 * ahead we can just read the next file. */
 			if(++it == names.end()) {
@@ -350,9 +407,11 @@ bool MetadataCache::readCategory(Category *cat) {
 			}
 		}
 
-		/* Read the cache file of the last version completely */
-		if(newest) {  // provided we have read the "last" version
-			get_common_info(pkg->name, neweststring, pkg);
+		/* Use the data of the cache file of the last version (if read) */
+		if((newest != NULLPTR) && likely(newest_info.valid)) {
+			pkg->homepage.swap(newest_info.homepage);
+			pkg->licenses.swap(newest_info.licenses);
+			pkg->desc.swap(newest_info.desc);
 		}
 	}
 	return true;
@@ -39,7 +39,7 @@ class MetadataCache FINAL : public BasicCache {
 			PATH_REPOSITORY
 		} PathType;
 		PathType path_type;
-		bool flat, have_override_path;
+		bool flat, have_override_path, prefetch;
 		std::string override_path;
 		std::string m_type;
 		std::string m_catpath;
@@ -50,8 +50,10 @@ class MetadataCache FINAL : public BasicCache {
 		void setType(PathType set_path_type, bool set_flat);
 		void setFlat(bool set_flat);
 
+		ATTRIBUTE_NONNULL_ void get_version_info(const std::string &pkg_name, const std::string &ver_name, Version *version, CommonInfo *common) const;
+
 	public:
-		MetadataCache() : reader(NULLPTR) {
+		MetadataCache() : prefetch(false), reader(NULLPTR) {
 		}
 
 		~MetadataCache() {
@@ -60,9 +62,14 @@ class MetadataCache FINAL : public BasicCache {
 
 		bool initialize(const std::string& name);
 
+		void setPrefetch() OVERRIDE {
+			prefetch = true;
+		}
+
 		ATTRIBUTE_NONNULL_ bool readCategoryPrepare(const char *cat_name) OVERRIDE;
 		ATTRIBUTE_NONNULL_ bool readCategory(Category *cat) OVERRIDE;
 		void readCategoryFinalize() OVERRIDE;
+		ATTRIBUTE_NONNULL_ bool get_category_stamp(std::string *stamp, const char *cat_name) OVERRIDE;
 
 		ATTRIBUTE_NONNULL_ const char *get_md5sum(const std::string &pkg_name, const std::string &ver_name) const OVERRIDE;
 		ATTRIBUTE_NONNULL_ bool get_time(std::time_t *t, const std::string &pkg_name, const std::string &ver_name) const OVERRIDE;
@@ -0,0 +1,450 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#include "cache/parallel_read.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cache/base.h"
+#include "database/header.h"
+#include "database/io.h"
+#include "database/package_reader.h"
+#include "database/trigrams.h"
+#include "eixTk/attribute.h"
+#include "eixTk/diagnostics.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/stringutils.h"
+#include "portage/package.h"
+#include "portage/packagetree.h"
+#include "portage/version.h"
+
+using std::set;
+using std::string;
+using std::vector;
+
+/**
+The records passed from the workers to the main process through the pipe
+are a type character followed by a string and a terminating '\0'
+**/
+#define RECORD_FOUND   'F'
+#define RECORD_EMPTY   'N'
+#define RECORD_ERROR   'E'
+#define RECORD_ABORTED 'A'
+#define RECORD_STATS   'S'
+
+typedef set<const Version *> VersionSet;
+typedef vector<Package *> PackageList;
+
+/**
+The pipe of the worker; needed in the (plain function) error callback
+**/
+static int worker_fd = -1;
+
+static bool write_all(int fd, const char *s, string::size_type len) {
+	while(len != 0) {
+		ssize_t r(write(fd, s, len));
+		if(unlikely(r < 0)) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		s += r;
+		len -= static_cast<string::size_type>(r);
+	}
+	return true;
+}
+
+static void send_record(char type, const string& str) {
+	string record(1, type);
+	record.append(str);
+	record.append(1, '\0');
+	if(unlikely(!write_all(worker_fd, record.c_str(), record.size()))) {
+		_exit(EXIT_FAILURE);
+	}
+}
+
+static void worker_error(const string& str) {
+	send_record(RECORD_ERROR, str);
+}
+
+/**
+Copy the versions of cat which are not in old to dest
+(together with the data of their packages)
+**/
+static void collect_new(Category *dest, const Category& cat, const VersionSet& old) {
+	for(Category::const_iterator p(cat.begin()); likely(p != cat.end()); ++p) {
+		Package *pkg(NULLPTR);
+		for(Package::const_iterator v(p->begin()); likely(v != p->end()); ++v) {
+			if(old.find(*v) != old.end()) {
+				continue;
+			}
+			if(pkg == NULLPTR) {
+				pkg = new Package(p->category, p->name);
+				pkg->homepage = p->homepage;
+				pkg->licenses = p->licenses;
+				pkg->desc     = p->desc;
+			}
+			pkg->addVersion(new Version(**v));
+		}
+		if(pkg != NULLPTR) {
+			dest->addPackage(pkg);
+		}
+	}
+}
+
+/**
+The worker: Read the categories of part into package_tree
+(which is the copy of the forked process, so that the new versions are
+compared with those of previous caches exactly as in serial reading)
+and write the new data to filename.
+**/
+ATTRIBUTE_NORETURN static void read_part(int fd, BasicCache *cache, PackageTree *package_tree, const DBHeader& header, const WordVec& part, const string& filename) {
+	// Errors are passed to the main process; nothing else should be output
+	int null_fd(open("/dev/null", O_WRONLY));
+	if(likely(null_fd >= 0)) {
+		dup2(null_fd, 1);
+		dup2(null_fd, 2);
+	}
+	worker_fd = fd;
+	cache->setErrorCallback(worker_error);
+	// Only the statistics of this process are passed
+	BasicCache::files_read = BasicCache::bytes_read = 0;
+	PackageTree result;
+	bool aborted(false);
+	for(WordVec::const_iterator it(part.begin()); likely(it != part.end()); ++it) {
+		Category *cat(package_tree->find(*it));
+		VersionSet old;
+		for(Category::const_iterator p(cat->begin()); likely(p != cat->end()); ++p) {
+			old.insert(p->begin(), p->end());
+		}
+		bool found(cache->readCategoryPrepare(it->c_str()));
+		if(found) {
+			if(!cache->readCategory(cat)) {
+				aborted = true;
+			}
+			collect_new(&(result[*it]), *cat, old);
+		}
+		cache->readCategoryFinalize();
+		send_record(found ? RECORD_FOUND : RECORD_EMPTY, *it);
+	}
+	if(aborted) {
+		send_record(RECORD_ABORTED, string());
+	}
+	send_record(RECORD_STATS, eix::format("%s %s")
+		% BasicCache::files_read % BasicCache::bytes_read);
+	DBHeader hdr(header);
+	hdr.use_stamps = false;
+	Trigrams::save_trigrams = false;
+	Database::prep_header_hashs(&hdr, result);
+	hdr.size = result.countCategories();
+	Database db;
+	if(unlikely(!db.openwrite(filename.c_str()))) {
+		_exit(EXIT_FAILURE);
+	}
+	string errtext;
+	if(unlikely(!(db.write_header(hdr, &errtext) &&
+		db.write_packagetree(result, hdr, &errtext)))) {
+		_exit(EXIT_FAILURE);
+	}
+	db.destroy();
+	_exit(EXIT_SUCCESS);
+}
+
+/**
+What the main process collects from the records of the workers.
+The statistics are added to BasicCache only if all workers succeed.
+**/
+class Records {
+	public:
+		ParallelReadCallback callback;
+		BasicCache::ErrorCallback error_callback;
+		WordSet *reported;
+		eix::UNumber files_read, bytes_read;
+		bool is_empty, aborted;
+
+		Records(ParallelReadCallback cb, BasicCache::ErrorCallback error_cb, WordSet *rep)
+			: callback(cb), error_callback(error_cb), reported(rep),
+			files_read(0), bytes_read(0), is_empty(true), aborted(false) {
+		}
+
+		/**
+		Add the statistics "files bytes" of a worker
+		**/
+		void add_stats(const string& str) {
+			string::size_type i(str.find(' '));
+			if(likely(i != string::npos)) {
+				files_read += my_atou(str.c_str());
+				bytes_read += my_atou(str.c_str() + i + 1);
+			}
+		}
+};
+
+/**
+Pass the complete records in buf to the callbacks and remove them from buf
+**/
+ATTRIBUTE_NONNULL_ static void handle_records(string *buf, Records *records) {
+	string::size_type start(0), end;
+	while((end = buf->find('\0', start)) != string::npos) {
+		string str(*buf, start + 1, end - start - 1);
+		switch((*buf)[start]) {
+			case RECORD_FOUND:
+				records->is_empty = false;
+				records->reported->INSERT(str);
+				(*(records->callback))(str, true);
+				break;
+			case RECORD_EMPTY:
+				records->reported->INSERT(str);
+				(*(records->callback))(str, false);
+				break;
+			case RECORD_ERROR:
+				(*(records->error_callback))(str);
+				break;
+			case RECORD_STATS:
+				records->add_stats(str);
+				break;
+			default:
+			// case RECORD_ABORTED:
+				records->aborted = true;
+				break;
+		}
+		start = end + 1;
+	}
+	buf->erase(0, start);
+}
+
+/**
+Read and handle the records of all workers in parallel
+**/
+ATTRIBUTE_NONNULL_ static bool read_records(const vector<int>& fds, Records *records) {
+	vector<struct pollfd> polls(fds.size());
+	for(vector<int>::size_type i(0); likely(i != fds.size()); ++i) {
+		polls[i].fd = fds[i];
+		polls[i].events = POLLIN;
+	}
+	vector<string> bufs(fds.size());
+	vector<int>::size_type open_fds(fds.size());
+	char buf[4096];
+	while(open_fds != 0) {
+		if(unlikely(poll(&(polls[0]), polls.size(), -1) < 0)) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		for(vector<int>::size_type i(0); likely(i != polls.size()); ++i) {
+			if((polls[i].fd < 0) || (polls[i].revents == 0)) {
+				continue;
+			}
+			ssize_t r(read(polls[i].fd, buf, sizeof(buf)));
+			if(r > 0) {
+				bufs[i].append(buf, static_cast<string::size_type>(r));
+				handle_records(&(bufs[i]), records);
+				continue;
+			}
+			if(unlikely(r < 0) && ((errno == EINTR) || (errno == EAGAIN))) {
+				continue;
+			}
+			if(unlikely(r < 0)) {
+				return false;
+			}
+			// End of file: Ignore this descriptor from now on
+			polls[i].fd = -1;
+			--open_fds;
+		}
+	}
+	return true;
+}
+
+/**
+Read the packages written by a worker
+**/
+static bool read_result(PackageList *packages, const string& filename) {
+	Database db;
+	if(unlikely(!db.openread(filename.c_str()))) {
+		return false;
+	}
+	DBHeader header;
+	string errtext;
+	if(unlikely(!db.read_header(&header, &errtext, DBHeader::current))) {
+		return false;
+	}
+	PackageReader reader(&db, header);
+	while(likely(reader.next())) {
+		Package *p(reader.release());
+		if(unlikely(p == NULLPTR)) {
+			break;
+		}
+		packages->PUSH_BACK(p);
+	}
+	return (likely(reader.get_errtext() == NULLPTR));
+}
+
+/**
+Merge a package read by a worker into package_tree.
+The description etc. is the one which the worker had after reading,
+because it would have been the same for serial reading.
+**/
+static void merge_package(PackageTree *package_tree, Package *p) {
+	Category& cat((*package_tree)[p->category]);
+	Package *pkg(cat.findPackage(p->name));
+	if(pkg == NULLPTR) {
+		cat.addPackage(p);
+		return;
+	}
+	for(Package::const_iterator v(p->begin()); likely(v != p->end()); ++v) {
+		pkg->addVersion(new Version(**v));
+	}
+	pkg->homepage = p->homepage;
+	pkg->licenses = p->licenses;
+	pkg->desc     = p->desc;
+	delete p;
+}
+
+static string make_tempfile(const string& tmpdir) {
+	string name(tmpdir.empty() ? string("/tmp") : tmpdir);
+	name.append("/eix-update.XXXXXXXX");
+	char *temp(new char[name.size() + 1]);
+	std::strcpy(temp, name.c_str());  // NOLINT(runtime/printf)
+	int fd(mkstemp(temp));
+	if(unlikely(fd == -1)) {
+		name.clear();
+	} else {
+		close(fd);
+		name.assign(temp);
+	}
+	delete[] temp;
+	return name;
+}
+
+bool parallel_read(BasicCache *cache, PackageTree *package_tree, const WordVec& categories, const DBHeader& header, unsigned int jobs, const string& tmpdir, ParallelReadCallback callback, BasicCache::ErrorCallback error_callback, bool *is_empty, bool *aborted, WordSet *reported) {
+	if((jobs <= 1) || cache->can_read_multiple_categories()) {
+		return false;
+	}
+	// Distribute the categories round-robin to balance the parts
+	vector<WordVec> parts;
+	if(categories.size() < jobs) {
+		jobs = categories.size();
+	}
+	if(jobs <= 1) {
+		return false;
+	}
+	parts.resize(jobs);
+	vector<WordVec>::size_type curr(0);
+	for(WordVec::const_iterator it(categories.begin());
+		likely(it != categories.end()); ++it) {
+		parts[curr].PUSH_BACK(*it);
+		if(++curr == parts.size()) {
+			curr = 0;
+		}
+	}
+	WordVec filenames;
+	vector<int> fds;
+	vector<pid_t> children;
+	bool success(true);
+	for(vector<WordVec>::const_iterator it(parts.begin());
+		likely(it != parts.end()); ++it) {
+		string filename(make_tempfile(tmpdir));
+		if(unlikely(filename.empty())) {
+			success = false;
+			break;
+		}
+		filenames.PUSH_BACK(filename);
+		int pipefd[2];
+		if(unlikely(pipe(pipefd) != 0)) {
+			success = false;
+			break;
+		}
+		pid_t child(fork());
+		if(unlikely(child == -1)) {
+			close(pipefd[0]);
+			close(pipefd[1]);
+			success = false;
+			break;
+		}
+		if(child == 0) {
+			close(pipefd[0]);
+			for(vector<int>::const_iterator fd(fds.begin()); likely(fd != fds.end()); ++fd) {
+				close(*fd);
+			}
+			read_part(pipefd[1], cache, package_tree, header, *it, filename);
+		}
+		close(pipefd[1]);
+		fds.PUSH_BACK(pipefd[0]);
+		children.PUSH_BACK(child);
+	}
+	Records records(callback, error_callback, reported);
+	if(likely(success)) {
+		success = read_records(fds, &records);
+	}
+	for(vector<int>::const_iterator fd(fds.begin()); likely(fd != fds.end()); ++fd) {
+		close(*fd);
+	}
+	for(vector<pid_t>::const_iterator child(children.begin());
+		likely(child != children.end()); ++child) {
+		int status;
+		pid_t r;
+		while(((r = waitpid(*child, &status, 0)) == -1) && (errno == EINTR)) {
+		}
+		if(unlikely(r != *child)) {
+			success = false;
+			continue;
+		}
+GCC_DIAG_OFF(old-style-cast)
+		if(!WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS)) {
+			success = false;
+		}
+GCC_DIAG_ON(old-style-cast)
+	}
+	PackageList packages;
+	for(WordVec::const_iterator it(filenames.begin());
+		likely(it != filenames.end()); ++it) {
+		if(likely(success)) {
+			success = read_result(&packages, *it);
+		}
+		unlink(it->c_str());
+	}
+	if(unlikely(!success)) {
+		for(PackageList::iterator it(packages.begin());
+			likely(it != packages.end()); ++it) {
+			delete *it;
+		}
+		return false;
+	}
+	// Each category was read by only one worker, so the order is irrelevant
+	for(PackageList::iterator it(packages.begin());
+		likely(it != packages.end()); ++it) {
+		merge_package(package_tree, *it);
+	}
+	BasicCache::files_read += records.files_read;
+	BasicCache::bytes_read += records.bytes_read;
+	if(!records.is_empty) {
+		*is_empty = false;
+	}
+	if(records.aborted) {
+		*aborted = true;
+	}
+	return true;
+}
@@ -0,0 +1,48 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#ifndef SRC_CACHE_PARALLEL_READ_H_
+#define SRC_CACHE_PARALLEL_READ_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+
+#include "cache/base.h"
+#include "eixTk/attribute.h"
+#include "eixTk/stringtypes.h"
+
+class DBHeader;
+class PackageTree;
+
+/**
+Called for every category once it has been read;
+found is false if readCategoryPrepare() had shown that it is empty.
+**/
+typedef void (*ParallelReadCallback)(const std::string& cat_name, bool found);
+
+/**
+Let jobs processes read the given categories of cache in parallel,
+each for a part of the categories. Every process reads into its own copy of
+package_tree and passes the new packages and versions to the main process
+through a temporary file in the format of the eix cachefile (in tmpdir).
+The main process merges these into package_tree.
+Processes are used instead of threads, since reading modifies lots of
+global state (e.g. the EAPI hash) and the caches are not reentrant.
+Only caches which read one category at a time are supported.
+The statistics of BasicCache are increased only if all processes succeed.
+@param callback is called in the main process whenever a category is done
+@param error_callback is called in the main process for error messages
+@param is_empty is set to false if some category was found
+@param aborted is set to true if some error caused incomplete read
+@param reported gets the categories for which callback was called
+@return false if nothing was done; package_tree is unchanged then, but
+callback might have been called for the categories in reported.
+**/
+ATTRIBUTE_NONNULL((1, 2, 9, 10, 11)) bool parallel_read(BasicCache *cache, PackageTree *package_tree, const WordVec& categories, const DBHeader& header, unsigned int jobs, const std::string& tmpdir, ParallelReadCallback callback, BasicCache::ErrorCallback error_callback, bool *is_empty, bool *aborted, WordSet *reported);
+
+#endif  // SRC_CACHE_PARALLEL_READ_H_
@@ -270,8 +270,13 @@ void ParseCache::parse_exec(const char *fullpath, const string& dirpath, bool re
 		string *cachefile(ebuild_exec->make_cachefile(fullpath, dirpath, *pkg, *version, eapi));
 		if(likely(cachefile != NULLPTR)) {
 			BasicReader *reader(newReader());
-			reader->get_keywords_slot_iuse_restrict(*cachefile, &eapi, &keywords, &slot, &iuse, &required_use, &restr, &props, &(version->depend), &(version->src_uri));
-			reader->read_file(*cachefile, pkg);
+			CommonInfo common;
+			reader->get_keywords_slot_iuse_restrict(*cachefile, &eapi, &keywords, &slot, &iuse, &required_use, &restr, &props, &(version->depend), &(version->src_uri), &common);
+			if(likely(common.valid)) {
+				pkg->homepage.swap(common.homepage);
+				pkg->licenses.swap(common.licenses);
+				pkg->desc.swap(common.desc);
+			}
 			delete reader;
 			ebuild_exec->delete_cachefile();
 		} else {
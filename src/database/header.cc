@@ -27,7 +27,8 @@ const DBHeader::SaveBitmask
 	DBHeader::SAVE_BITMASK_NONE,
 	DBHeader::SAVE_BITMASK_DEP,
 	DBHeader::SAVE_BITMASK_REQUIRED_USE,
-	DBHeader::SAVE_BITMASK_SRC_URI;
+	DBHeader::SAVE_BITMASK_SRC_URI,
+	DBHeader::SAVE_BITMASK_TRIGRAMS;
 
 const DBHeader::OverlayTest
 	DBHeader::OVTEST_NONE,
@@ -48,7 +49,7 @@ practically sure the first match should be it; if not, the second.
 The remainder is meant for museum systems.)
 **/
 const DBHeader::DBVersion DBHeader::accept[] = {
-	DBHeader::current, 38, 37, 36, 35, 34, 33, 32, 31,
+	DBHeader::current, 39, 38, 37, 36, 35, 34, 33, 32, 31,
 	0
 };
 
@@ -12,8 +12,10 @@
 
 #include <config.h>  // IWYU pragma: keep
 
+#include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
@@ -21,10 +23,31 @@
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
 #include "portage/extendedversion.h"
+#include "portage/keywords.h"
 #include "portage/overlay.h"
+#include "portage/version.h"
 
 class PortageSettings;
 
+/**
+The stamps of the categories of the cache of an overlay.
+They are used by eix-update to decide which categories need to be reread;
+see BasicCache::get_category_stamp().
+**/
+class CacheStamps {
+	public:
+		typedef std::map<std::string, std::string> Categories;
+
+		/**
+		The type of the cache; empty if the cache does not support stamps
+		**/
+		std::string type;
+
+		Categories categories;
+};
+
+typedef std::vector<CacheStamps> CacheStampsVec;
+
 /**
 Representation of a database-header.
 Contains your arch, the version of the db, the number of packages/categories
@@ -46,14 +69,32 @@ class DBHeader {
 			slot_hash,
 			depend_hash;
 
+		/**
+		The KeywordIds of the entries of keywords_hash
+		**/
+		KeywordIds::List keywords_ids;
+
+		/**
+		The interned IUse of the entries of iuse_hash
+		**/
+		IUseSet::IUseStd iuse_ids;
+
 		typedef  eix::UNumber SaveBitmask;
 		static CONSTEXPR const SaveBitmask
 			SAVE_BITMASK_NONE         = 0x00U,
 			SAVE_BITMASK_DEP          = 0x01U,
 			SAVE_BITMASK_REQUIRED_USE = 0x02U,
-			SAVE_BITMASK_SRC_URI      = 0x04U;
+			SAVE_BITMASK_SRC_URI      = 0x04U,
+			SAVE_BITMASK_TRIGRAMS     = 0x08U,
+			SAVE_BITMASK_STAMPS       = 0x10U;
 
-		bool use_depend, use_required_use, use_src_uri;
+		bool use_depend, use_required_use, use_src_uri, use_trigrams, use_stamps;
+
+		/**
+		The stamps for each overlay (only used for writing;
+		reading is done on demand with Database::read_stamps())
+		**/
+		CacheStampsVec stamps;
 
 		WordVec world_sets;
 
@@ -75,7 +116,7 @@ class DBHeader {
 		/**
 		Current version of database-format and what we accept
 		**/
-		static CONSTEXPR const DBVersion current = 39;
+		static CONSTEXPR const DBVersion current = 40;
 		static const DBHeader::DBVersion accept[];
 
 		/**
@@ -87,6 +128,37 @@ class DBHeader {
 		**/
 		eix::Catsize size;
 
+		/**
+		Position of the category/package index in the file and of
+		the first category. Both are 0 if the file has no index.
+		**/
+		eix::OffsetType index_offset, tree_offset;
+
+		/**
+		Position of the trigram index in the file or 0
+		**/
+		eix::OffsetType trigram_offset;
+
+		/**
+		Position of the stamps in the file or 0
+		**/
+		eix::OffsetType stamps_offset;
+
+		DBHeader() : use_stamps(false), index_offset(0), tree_offset(0), trigram_offset(0), stamps_offset(0) {
+		}
+
+		bool have_index() const {
+			return (index_offset != 0);
+		}
+
+		bool have_trigrams() const {
+			return (trigram_offset != 0);
+		}
+
+		bool have_stamps() const {
+			return (stamps_offset != 0);
+		}
+
 		/**
 		Get overlay for key from table
 		**/
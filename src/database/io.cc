@@ -8,6 +8,10 @@
 #include "database/io.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
 #include <cstdio>
 
 #include <string>
@@ -17,7 +21,6 @@
 #endif
 
 #include "database/header.h"
-#include "eixTk/auto_array.h"
 #include "eixTk/diagnostics.h"
 #include "eixTk/eixint.h"
 #include "eixTk/i18n.h"
@@ -28,6 +31,8 @@
 
 using std::string;
 
+bool File::use_mmap = true;
+
 bool File::openread(const char *name) {
 	if((fp = std::fopen(name, "rb")) == NULLPTR) {
 		return false;
@@ -36,10 +41,48 @@ bool File::openread(const char *name) {
 #ifdef HAVE_FLOCK
 	flock(fileno(fp), LOCK_SH);
 #endif
+	if(likely(use_mmap)) {
+		map();
+	}
 #endif
 	return true;
 }
 
+/**
+Map the opened file into memory. If this fails, we silently
+fall back to the FILE-based functions.
+**/
+void File::map() {
+#ifdef HAVE_FILENO
+	int fd(fileno(fp));
+	struct stat st;
+	if(unlikely(fstat(fd, &st) != 0) || unlikely(st.st_size <= 0)) {
+		return;
+	}
+GCC_DIAG_OFF(sign-conversion)
+	void *buffer = mmap(NULLPTR, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+GCC_DIAG_ON(sign-conversion)
+GCC_DIAG_OFF(old-style-cast)
+	if(unlikely(buffer == MAP_FAILED)) {
+GCC_DIAG_ON(old-style-cast)
+		return;
+	}
+	m_map = static_cast<const eix::UChar *>(buffer);
+	m_curr = m_map;
+	m_map_end = m_map + st.st_size;
+#endif
+}
+
+void File::unmap() {
+	if(m_map == NULLPTR) {
+		return;
+	}
+GCC_DIAG_OFF(sign-conversion)
+	munmap(const_cast<eix::UChar *>(m_map), m_map_end - m_map);
+GCC_DIAG_ON(sign-conversion)
+	m_map = NULLPTR;
+}
+
 bool File::openwrite(const char *name) {
 	if((fp = std::fopen(name, "wb")) == NULLPTR) {
 		return false;
@@ -52,9 +95,10 @@ bool File::openwrite(const char *name) {
 	return true;
 }
 
-void File::destroy() {
-	if(unlikely(fp == NULLPTR)) {
-		return;
+bool File::close() {
+	unmap();
+	if(fp == NULLPTR) {
+		return true;
 	}
 #ifdef HAVE_FILENO
 #ifdef HAVE_FLOCK
@@ -63,16 +107,26 @@ void File::destroy() {
 	// flock(fileno(fp), LOCK_UN);
 #endif
 #endif
-	std::fclose(fp);
+	bool ok(std::fclose(fp) == 0);
+	fp = NULLPTR;
+	return ok;
 }
 
 bool File::seek(eix::OffsetType offset, int whence, string *errtext) {
+	if(likely(m_map != NULLPTR)) {
+		const eix::UChar *base((whence == SEEK_SET) ? m_map : m_curr);
+		if(likely((offset >= m_map - base) && (offset <= m_map_end - base))) {
+			m_curr = base + offset;
+			return true;
+		}
+	} else {
 #ifdef HAVE_FSEEKO
-	if(likely(fseeko(fp, offset, whence) == 0))
+		if(likely(fseeko(fp, offset, whence) == 0))
 #else
-	if(likely(std::fseek(fp, offset, whence) == 0))
+		if(likely(std::fseek(fp, offset, whence) == 0))
 #endif
-		return true;
+			return true;
+	}
 	if(errtext != NULLPTR) {
 		*errtext = _("fseek failed");
 	}
@@ -80,6 +134,9 @@ bool File::seek(eix::OffsetType offset, int whence, string *errtext) {
 }
 
 eix::OffsetType File::tell() {
+	if(likely(m_map != NULLPTR)) {
+		return (m_curr - m_map);
+	}
 #ifdef HAVE_FSEEKO
 	// We rely on autoconf whose documentation states:
 	// All systems with fseeko() also supply ftello()
@@ -97,6 +154,24 @@ bool File::read_string_plain(char *s, string::size_type len, string *errtext) {
 	return false;
 }
 
+bool File::read_string_plain(string *s, string::size_type len, string *errtext) {
+	if(likely(m_map != NULLPTR)) {
+		const char *p(read_mapped(len));
+		if(likely(p != NULLPTR)) {
+			s->assign(p, len);
+			return true;
+		}
+		readError(errtext);
+		return false;
+	}
+	// Read directly into the string to reuse its capacity
+	s->resize(len);
+	if(len == 0) {
+		return true;
+	}
+	return read_string_plain(&((*s)[0]), len, errtext);
+}
+
 bool File::write_string_plain(const string& str, string *errtext) {
 	if(likely(write(str))) {
 		return true;
@@ -107,7 +182,7 @@ bool File::write_string_plain(const string& str, string *errtext) {
 
 void File::readError(string *errtext) {
 	if(errtext != NULLPTR) {
-		*errtext = (feof(fp) ?
+		*errtext = (((m_map != NULLPTR) ? (m_curr == m_map_end) : feof(fp)) ?
 			_("error while reading from database: end of file") :
 			_("error while reading from database"));
 	}
@@ -154,13 +229,7 @@ bool Database::read_string(string *s, string *errtext) {
 	if(unlikely(!read_num(&len, errtext))) {
 		return false;
 	}
-	eix::auto_array<char> buf(new char[len + 1]);
-	buf.get()[len] = 0;
-	if(likely(read_string_plain(buf.get(), len, errtext))) {
-		*s = buf.get();
-		return true;
-	}
-	return false;
+	return read_string_plain(s, len, errtext);
 }
 
 bool Database::skip_string(string *errtext) {
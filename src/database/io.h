@@ -11,10 +11,13 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <cstdio>
+#include <cstring>
 
 #include <string>
+#include <vector>
 
 #include "database/header.h"
+#include "database/trigrams.h"
 #include "eixTk/attribute.h"
 #include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
@@ -23,30 +26,44 @@
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "portage/version.h"
 
 // check_includes: include "portage/basicversion.h"
 
 class BasicPart;
-class IUseSet;
+class Category;
 class Package;
 class PackageReader;
 class PackageTree;
 class PortageSettings;
 class Depend;
-class Version;
 
 #define MAGICNUMCHAR 0xFFU
 
 class File {
 	private:
 		FILE *fp;
+
+		/**
+		If the file is mapped into memory, all reading is done from
+		the range [m_map, m_map_end) and fp is only kept for the lock
+		**/
+		const eix::UChar *m_map, *m_curr, *m_map_end;
+
 		bool seek(eix::OffsetType offset, int whence, std::string *errtext);
+		void map();
+		void unmap();
 
 		File(const File& s) ASSIGN_DELETE;
 		File& operator=(const File& s) ASSIGN_DELETE;
 
 	public:
-		File() : fp(NULLPTR) {
+		/**
+		Whether openread() should try to map the file into memory
+		**/
+		static bool use_mmap;
+
+		File() : fp(NULLPTR), m_map(NULLPTR), m_curr(NULLPTR), m_map_end(NULLPTR) {
 		}
 
 		~File() {
@@ -54,23 +71,42 @@ class File {
 		}
 
 #ifdef HAVE_MOVE
-		File(File&& s) NOEXCEPT : fp(s.fp) {
+		File(File&& s) NOEXCEPT : fp(s.fp), m_map(s.m_map), m_curr(s.m_curr), m_map_end(s.m_map_end) {
 			s.fp = NULLPTR;
+			s.m_map = NULLPTR;
 		}
 
 		File& operator=(File&& s) NOEXCEPT {
 			destroy();
 			fp = s.fp;
+			m_map = s.m_map;
+			m_curr = s.m_curr;
+			m_map_end = s.m_map_end;
 			s.fp = NULLPTR;
+			s.m_map = NULLPTR;
 			return *this;
 		}
 #endif
-		void destroy();
+		void destroy() {
+			close();
+		}
+
+		/**
+		@return false if flushing the written data failed
+		**/
+		bool close();
 
 		ATTRIBUTE_NONNULL_ bool openread(const char *name);
 		ATTRIBUTE_NONNULL_ bool openwrite(const char *name);
 
+		bool is_mapped() const {
+			return (m_map != NULLPTR);
+		}
+
 		int getch() {
+			if(likely(m_map != NULLPTR)) {
+				return (likely(m_curr != m_map_end) ? static_cast<int>(*(m_curr++)) : EOF);
+			}
 			return std::fgetc(fp);
 		}
 
@@ -79,14 +115,37 @@ class File {
 		}
 
 		bool read(char *s, std::string::size_type len) {
+			if(likely(m_map != NULLPTR)) {
+				const char *p(read_mapped(len));
+				if(unlikely(p == NULLPTR)) {
+					return false;
+				}
+				std::memcpy(s, p, len);
+				return true;
+			}
 			return (std::fread(s, sizeof(*s), len, fp) == len);
 		}
 
+		/**
+		Only for mapped files: Return a pointer to the next len bytes
+		and skip them. Return NULLPTR if not enough data is left.
+		**/
+		const char *read_mapped(std::string::size_type len) {
+			if(unlikely(len > static_cast<std::string::size_type>(m_map_end - m_curr))) {
+				m_curr = m_map_end;
+				return NULLPTR;
+			}
+			const char *p(reinterpret_cast<const char *>(m_curr));
+			m_curr += len;
+			return p;
+		}
+
 		bool write(const std::string str) {
 			return (std::fwrite(static_cast<const void *>(str.c_str()), sizeof(*(str.c_str())), str.size(), fp) == str.size());
 		}
 
 		ATTRIBUTE_NONNULL((2)) bool read_string_plain(char *s, std::string::size_type len, std::string *errtext);
+		ATTRIBUTE_NONNULL((2)) bool read_string_plain(std::string *s, std::string::size_type len, std::string *errtext);
 		bool write_string_plain(const std::string& str, std::string *errtext);
 
 		bool seekrel(eix::OffsetType offset, std::string *errtext) {
@@ -157,7 +216,7 @@ class Database : public File {
 		ATTRIBUTE_NONNULL((3)) bool read_hash_words(const StringHash& hash, std::string *s, std::string *errtext);
 		bool read_hash_words(std::string *errtext);
 
-		ATTRIBUTE_NONNULL((3)) bool read_iuse(const StringHash& hash, IUseSet *iuse, std::string *errtext);
+		ATTRIBUTE_NONNULL((3)) bool read_iuse(const IUseSet::IUseStd& ids, IUseSet *iuse, std::string *errtext);
 
 		ATTRIBUTE_NONNULL((2)) bool read_version(Version *v, const DBHeader& hdr, std::string *errtext);
 		ATTRIBUTE_NONNULL((2)) bool write_version(const Version *v, const DBHeader& hdr, std::string *errtext);
@@ -174,6 +233,13 @@ class Database : public File {
 		bool write_hash(const StringHash& hash, std::string *errtext);
 		ATTRIBUTE_NONNULL((2)) bool read_hash(StringHash *hash, std::string *errtext);
 
+		typedef std::vector<eix::OffsetType> OffsetVec;
+		bool write_index_packages(const Category& cat, OffsetVec::const_iterator offset, std::string *errtext);
+		bool write_index(const PackageTree& tree, const OffsetVec& offsets, std::string *errtext);
+		bool write_postings(const Trigrams::Postings& postings, std::string *errtext);
+		bool write_trigrams(const Trigrams::Index& trigrams, std::string *errtext);
+		bool write_stamps(const CacheStampsVec& stamps, std::string *errtext);
+
 	public:
 		Database() : counting(false), counter(0) {
 		}
@@ -183,6 +249,11 @@ class Database : public File {
 		bool write_header(const DBHeader& hdr, std::string *errtext);
 		ATTRIBUTE_NONNULL((2)) bool read_header(DBHeader *hdr, std::string *errtext, DBHeader::DBVersion minver);
 
+		/**
+		Read the stamps of the categories (if the file has some)
+		**/
+		ATTRIBUTE_NONNULL((3)) bool read_stamps(const DBHeader& hdr, CacheStampsVec *stamps, std::string *errtext);
+
 		bool write_packagetree(const PackageTree& pkg, const DBHeader& hdr, std::string *errtext);
 #if 0
 		ATTRIBUTE_NONNULL((2, 4)) bool read_packagetree(PackageTree *tree, const DBHeader& hdr, PortageSettings *ps, std::string *errtext);
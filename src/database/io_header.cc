@@ -27,6 +27,7 @@
 #include "eixTk/stringutils.h"
 #include "portage/depend.h"
 #include "portage/extendedversion.h"
+#include "portage/version.h"
 
 using std::string;
 using std::vector;
@@ -96,9 +97,19 @@ GCC_DIAG_ON(sign-conversion)
 	if(unlikely(!read_hash(&(hdr->keywords_hash), errtext))) {
 		return false;
 	}
+	hdr->keywords_ids.clear();
+	for(StringHash::const_iterator it(hdr->keywords_hash.begin());
+		likely(it != hdr->keywords_hash.end()); ++it) {
+		hdr->keywords_ids.PUSH_BACK(KeywordIds::intern(*it));
+	}
 	if(unlikely(!read_hash(&(hdr->iuse_hash), errtext))) {
 		return false;
 	}
+	hdr->iuse_ids.clear();
+	for(StringHash::const_iterator it(hdr->iuse_hash.begin());
+		likely(it != hdr->iuse_hash.end()); ++it) {
+		hdr->iuse_ids.EMPLACE_BACK(IUse, (*it));
+	}
 	if(unlikely(!read_hash(&(hdr->slot_hash), errtext))) {
 		return false;
 	}
@@ -121,6 +132,8 @@ GCC_DIAG_ON(sign-conversion)
 	}
 	hdr->use_required_use = ((save_bitmask & DBHeader::SAVE_BITMASK_REQUIRED_USE) != DBHeader::SAVE_BITMASK_NONE);
 	hdr->use_src_uri = ((save_bitmask & DBHeader::SAVE_BITMASK_SRC_URI) != DBHeader::SAVE_BITMASK_NONE);
+	hdr->use_trigrams = ((save_bitmask & DBHeader::SAVE_BITMASK_TRIGRAMS) != DBHeader::SAVE_BITMASK_NONE);
+	hdr->use_stamps = ((save_bitmask & DBHeader::SAVE_BITMASK_STAMPS) != DBHeader::SAVE_BITMASK_NONE);
 	if((hdr->use_depend = ((save_bitmask & DBHeader::SAVE_BITMASK_DEP) != DBHeader::SAVE_BITMASK_NONE))) {
 		eix::OffsetType len;
 		if(unlikely(!read_num(&len, errtext))) {
@@ -136,6 +149,73 @@ GCC_DIAG_ON(sign-conversion)
 			}
 		}
 	}
+	hdr->trigram_offset = hdr->stamps_offset = 0;
+	if(hdr->version <= 39) {
+		hdr->index_offset = hdr->tree_offset = 0;
+		return true;
+	}
+	// The indices are only read on demand by PackageReader
+	eix::OffsetType len;
+	if(unlikely(!read_num(&len, errtext))) {
+		return false;
+	}
+	hdr->index_offset = tell();
+	if(unlikely(!seekrel(len, errtext))) {
+		return false;
+	}
+	if(hdr->use_trigrams) {
+		if(unlikely(!read_num(&len, errtext))) {
+			return false;
+		}
+		hdr->trigram_offset = tell();
+		if(unlikely(!seekrel(len, errtext))) {
+			return false;
+		}
+	}
+	if(hdr->use_stamps) {
+		if(unlikely(!read_num(&len, errtext))) {
+			return false;
+		}
+		hdr->stamps_offset = tell();
+		if(unlikely(!seekrel(len, errtext))) {
+			return false;
+		}
+	}
+	hdr->tree_offset = tell();
+	return true;
+}
+
+bool Database::read_stamps(const DBHeader& hdr, CacheStampsVec *stamps, string *errtext) {
+	stamps->clear();
+	if(!hdr.have_stamps()) {
+		return true;
+	}
+	if(unlikely(!seekabs(hdr.stamps_offset, errtext))) {
+		return false;
+	}
+	CacheStampsVec::size_type i;
+	if(unlikely(!read_num(&i, errtext))) {
+		return false;
+	}
+	stamps->resize(i);
+	for(CacheStampsVec::iterator it(stamps->begin()); likely(it != stamps->end()); ++it) {
+		if(unlikely(!read_string(&(it->type), errtext))) {
+			return false;
+		}
+		CacheStamps::Categories::size_type j;
+		if(unlikely(!read_num(&j, errtext))) {
+			return false;
+		}
+		for(; likely(j != 0); --j) {
+			string cat_name;
+			if(unlikely(!read_string(&cat_name, errtext))) {
+				return false;
+			}
+			if(unlikely(!read_string(&(it->categories[cat_name]), errtext))) {
+				return false;
+			}
+		}
+	}
 	return true;
 }
 
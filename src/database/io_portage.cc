@@ -9,10 +9,11 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <string>
+#include <vector>
 
 #include "database/header.h"
 #include "database/package_reader.h"
-#include "eixTk/auto_array.h"
+#include "database/trigrams.h"
 #include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
 #include "eixTk/eixint.h"
@@ -53,30 +54,30 @@ bool Database::read_Part(BasicPart *b, string *errtext) {
 	BasicPart::PartType type(BasicPart::PartType(len % BasicPart::max_type));
 	len /= BasicPart::max_type;
 	if(len != 0) {
-		eix::auto_array<char> buf(new char[len + 1]);
-		buf.get()[len] = 0;
-		if(unlikely(!read_string_plain(buf.get(), len, errtext))) {
+		string content;
+		if(unlikely(!read_string_plain(&content, len, errtext))) {
 			return false;
 		}
-		*b = BasicPart(type, string(buf.get()));
+		*b = BasicPart(type, content);
 		return true;
 	}
 	*b = BasicPart(type);
 	return true;
 }
 
-bool Database::read_iuse(const StringHash& hash, IUseSet *iuse, string *errtext) {
+bool Database::read_iuse(const IUseSet::IUseStd& ids, IUseSet *iuse, string *errtext) {
 	iuse->clear();
 	eix::UNumber e;
 	if(unlikely(!read_num(&e, errtext))) {
 		return false;
 	}
+	// The ids are translated from the indices of the hash
 	for(; e; --e) {
-		string s;
-		if(unlikely(!read_hash_string(hash, &s, errtext))) {
+		StringHash::size_type index;
+		if(unlikely(!read_num(&index, errtext))) {
 			return false;
 		}
-		iuse->insert_fast(s);
+		iuse->insert(ids[index]);
 	}
 	return true;
 }
@@ -104,9 +105,20 @@ bool Database::read_version(Version *v, const DBHeader& hdr, string *errtext) {
 	if(unlikely(!read_num(&(v->restrictFlags), errtext))) {
 		return false;
 	}
-	if(unlikely(!read_hash_words(hdr.keywords_hash, &(v->full_keywords), errtext))) {
+	// read the keywords: the ids are translated from the indices of the hash
+	WordVec::size_type e;
+	if(unlikely(!read_num(&e, errtext))) {
 		return false;
 	}
+	v->full_keyword_ids.clear();
+	v->full_keyword_ids.reserve(e);
+	for(; e != 0; --e) {
+		StringHash::size_type index;
+		if(unlikely(!read_num(&index, errtext))) {
+			return false;
+		}
+		v->full_keyword_ids.PUSH_BACK(hdr.keywords_ids[index]);
+	}
 
 	// read primary version part
 	BasicVersion::PartsType::size_type i;
@@ -134,7 +146,7 @@ bool Database::read_version(Version *v, const DBHeader& hdr, string *errtext) {
 	v->reponame = overlay.label;
 	v->priority = overlay.priority;
 
-	if(unlikely(!read_iuse(hdr.iuse_hash, &(v->iuse), errtext))) {
+	if(unlikely(!read_iuse(hdr.iuse_ids, &(v->iuse), errtext))) {
 		return false;
 	}
 	if(hdr.use_required_use) {
@@ -201,7 +213,9 @@ bool Database::write_version(const Version *v, const DBHeader& hdr, string *errt
 	}
 
 	// write full keywords
-	if(unlikely(!write_hash_words(hdr.keywords_hash, v->get_full_keywords(), errtext))) {
+	WordVec keywords;
+	v->get_full_keywords(&keywords);
+	if(unlikely(!write_hash_words(hdr.keywords_hash, keywords, errtext))) {
 		return false;
 	}
 
@@ -357,6 +371,7 @@ void Database::prep_header_hashs(DBHeader *hdr, const PackageTree& tree) {
 		hdr->depend_hash.init(true);
 	}
 	hdr->use_src_uri = ExtendedVersion::use_src_uri;
+	hdr->use_trigrams = Trigrams::save_trigrams;
 	bool use_required_use(Version::use_required_use);
 	hdr->use_required_use = use_required_use;
 	for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
@@ -365,7 +380,9 @@ void Database::prep_header_hashs(DBHeader *hdr, const PackageTree& tree) {
 			hdr->license_hash.hash_string(p->licenses);
 			for(Package::iterator v(p->begin()); likely(v != p->end()); ++v) {
 				hdr->eapi_hash.hash_string(v->eapi.get());
-				hdr->keywords_hash.hash_words(v->get_full_keywords());
+				WordVec keywords;
+				v->get_full_keywords(&keywords);
+				hdr->keywords_hash.hash_words(keywords);
 				hdr->iuse_hash.hash_words(v->iuse.asVector());
 				if(use_required_use) {
 					hdr->iuse_hash.hash_words(v->required_use);
@@ -451,6 +468,12 @@ bool Database::write_header(const DBHeader& hdr, string *errtext) {
 	if(hdr.use_required_use) {
 		save_bitmask |= DBHeader::SAVE_BITMASK_REQUIRED_USE;
 	}
+	if(hdr.use_trigrams) {
+		save_bitmask |= DBHeader::SAVE_BITMASK_TRIGRAMS;
+	}
+	if(hdr.use_stamps) {
+		save_bitmask |= DBHeader::SAVE_BITMASK_STAMPS;
+	}
 	if(unlikely(!write_num(save_bitmask, errtext))) {
 		return false;
 	}
@@ -461,7 +484,160 @@ bool Database::write_header(const DBHeader& hdr, string *errtext) {
 	return write_hash(hdr.depend_hash, errtext);
 }
 
+bool Database::write_index_packages(const Category& cat, OffsetVec::const_iterator offset, string *errtext) {
+	if(unlikely(!write_num(cat.size(), errtext))) {
+		return false;
+	}
+	for(Category::const_iterator p(cat.begin()); likely(p != cat.end()); ++p) {
+		if(unlikely(!write_string((*p)->name, errtext))) {
+			return false;
+		}
+		if(unlikely(!write_num(*(offset++), errtext))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+The offsets (relative to the first category) are in the order in
+which they appear in the tree: Each category followed by its packages
+**/
+bool Database::write_index(const PackageTree& tree, const OffsetVec& offsets, string *errtext) {
+	OffsetVec::const_iterator offset(offsets.begin());
+	for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
+		const Category *ci(c->second);
+		if(unlikely(!write_string(c->first, errtext))) {
+			return false;
+		}
+		if(unlikely(!write_num(*(offset++), errtext))) {
+			return false;
+		}
+		WRITE_COUNTER(write_index_packages(*ci, offset, NULLPTR));
+		if(unlikely(!write_index_packages(*ci, offset, errtext))) {
+			return false;
+		}
+		offset += ci->size();
+	}
+	return true;
+}
+
+bool Database::write_postings(const Trigrams::Postings& postings, string *errtext) {
+	if(unlikely(!write_num(postings.size(), errtext))) {
+		return false;
+	}
+	// Postings are sorted: Store the differences
+	eix::OffsetType prev(0);
+	for(Trigrams::Postings::const_iterator it(postings.begin());
+		likely(it != postings.end()); ++it) {
+		if(unlikely(!write_num(*it - prev, errtext))) {
+			return false;
+		}
+		prev = *it;
+	}
+	return true;
+}
+
+/**
+First the keys with the lengths of their postings, then the postings
+**/
+bool Database::write_trigrams(const Trigrams::Index& trigrams, string *errtext) {
+	if(unlikely(!write_num(trigrams.size(), errtext))) {
+		return false;
+	}
+	for(Trigrams::Index::const_iterator it(trigrams.begin());
+		likely(it != trigrams.end()); ++it) {
+		if(unlikely(!write_num(it->first, errtext))) {
+			return false;
+		}
+		WRITE_COUNTER(write_postings(it->second, NULLPTR));
+	}
+	for(Trigrams::Index::const_iterator it(trigrams.begin());
+		likely(it != trigrams.end()); ++it) {
+		if(unlikely(!write_postings(it->second, errtext))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Database::write_stamps(const CacheStampsVec& stamps, string *errtext) {
+	if(unlikely(!write_num(stamps.size(), errtext))) {
+		return false;
+	}
+	for(CacheStampsVec::const_iterator it(stamps.begin()); likely(it != stamps.end()); ++it) {
+		if(unlikely(!write_string(it->type, errtext))) {
+			return false;
+		}
+		if(unlikely(!write_num(it->categories.size(), errtext))) {
+			return false;
+		}
+		for(CacheStamps::Categories::const_iterator c(it->categories.begin());
+			likely(c != it->categories.end()); ++c) {
+			if(unlikely(!write_string(c->first, errtext))) {
+				return false;
+			}
+			if(unlikely(!write_string(c->second, errtext))) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
 bool Database::write_packagetree(const PackageTree& tree, const DBHeader& hdr, string *errtext) {
+	// Collect the offsets for the index in a counting pass
+	OffsetVec offsets;
+	{
+		eix::OffsetType counter_save(counter);
+		bool counting_save(counting);
+		counter = 0;
+		counting = true;
+		for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
+			const Category *ci(c->second);
+			offsets.PUSH_BACK(counter);
+			write_category_header(c->first, eix::Treesize(ci->size()), NULLPTR);
+			for(Category::const_iterator p(ci->begin()); likely(p != ci->end()); ++p) {
+				offsets.PUSH_BACK(counter);
+				write_package(**p, hdr, NULLPTR);
+			}
+		}
+		counting = counting_save;
+		counter = counter_save;
+	}
+	WRITE_COUNTER(write_index(tree, offsets, NULLPTR));
+	if(unlikely(!write_index(tree, offsets, errtext))) {
+		return false;
+	}
+	if(hdr.use_trigrams) {
+		Trigrams::Index trigrams;
+		Trigrams::Keys keys;
+		OffsetVec::const_iterator offset(offsets.begin());
+		for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
+			const Category *ci(c->second);
+			++offset;
+			for(Category::const_iterator p(ci->begin()); likely(p != ci->end()); ++p) {
+				keys.clear();
+				Trigrams::add(&keys, **p);
+				Trigrams::normalize(&keys);
+				for(Trigrams::Keys::const_iterator k(keys.begin()); likely(k != keys.end()); ++k) {
+					trigrams[*k].PUSH_BACK(*offset);
+				}
+				++offset;
+			}
+		}
+		WRITE_COUNTER(write_trigrams(trigrams, NULLPTR));
+		if(unlikely(!write_trigrams(trigrams, errtext))) {
+			return false;
+		}
+	}
+	if(hdr.use_stamps) {
+		WRITE_COUNTER(write_stamps(hdr.stamps, NULLPTR));
+		if(unlikely(!write_stamps(hdr.stamps, errtext))) {
+			return false;
+		}
+	}
+
 	for(PackageTree::const_iterator c(tree.begin()); likely(c != tree.end()); ++c) {
 		Category *ci(c->second);
 		// Write category-header followed by a list of the packages.
@@ -0,0 +1,98 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#include "database/package_fields.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+
+#include "eixTk/dialect.h"
+#include "eixTk/likely.h"
+#include "eixTk/stringtypes.h"
+#include "portage/conf/portagesettings.h"
+#include "portage/depend.h"
+#include "portage/package.h"
+#include "portage/version.h"
+
+using std::string;
+
+const string& PackageFields::category_name(const Package *pkg) {
+	if((m_have & HAVE_CATEGORY_NAME) == HAVE_NONE) {
+		m_have |= HAVE_CATEGORY_NAME;
+		m_category_name.assign(pkg->category);
+		m_category_name.append(1, '/');
+		m_category_name.append(pkg->name);
+	}
+	return m_category_name;
+}
+
+const WordVec& PackageFields::longslots(const Package *pkg) {
+	if((m_have & HAVE_LONGSLOTS) == HAVE_NONE) {
+		m_have |= HAVE_LONGSLOTS;
+		m_longslots.clear();
+		for(Package::const_iterator it(pkg->begin()); likely(it != pkg->end()); ++it) {
+			m_longslots.PUSH_BACK(it->get_longslot());
+		}
+	}
+	return m_longslots;
+}
+
+const WordVec& PackageFields::longfullslots(const Package *pkg) {
+	if((m_have & HAVE_LONGFULLSLOTS) == HAVE_NONE) {
+		m_have |= HAVE_LONGFULLSLOTS;
+		m_longfullslots.clear();
+		for(Package::const_iterator it(pkg->begin()); likely(it != pkg->end()); ++it) {
+			m_longfullslots.PUSH_BACK(it->get_longfullslot());
+		}
+	}
+	return m_longfullslots;
+}
+
+const WordVec& PackageFields::depends(const Package *pkg, DependKind kind) {
+	WordVec& result(m_depends[kind]);
+	Have have(HAVE_DEPEND << kind);
+	if((m_have & have) == HAVE_NONE) {
+		m_have |= have;
+		result.clear();
+		for(Package::const_iterator it(pkg->begin()); likely(it != pkg->end()); ++it) {
+			const Depend& dep(it->depend);
+			switch(kind) {
+				case DEPEND:
+					result.PUSH_BACK(dep.get_depend());
+					break;
+				case RDEPEND:
+					result.PUSH_BACK(dep.get_rdepend());
+					break;
+				case PDEPEND:
+					result.PUSH_BACK(dep.get_pdepend());
+					break;
+				case BDEPEND:
+					result.PUSH_BACK(dep.get_bdepend());
+					break;
+				default:
+				// case IDEPEND:
+					result.PUSH_BACK(dep.get_idepend());
+					break;
+			}
+		}
+	}
+	return result;
+}
+
+const WordVec& PackageFields::setnames(const Package *pkg, const PortageSettings *ps) {
+	if((m_have & HAVE_SETNAMES) == HAVE_NONE) {
+		m_have |= HAVE_SETNAMES;
+		m_setnames.clear();
+		WordSet names;
+		ps->get_setnames(&names, pkg);
+		for(WordSet::const_iterator it(names.begin()); likely(it != names.end()); ++it) {
+			m_setnames.PUSH_BACK(*it);
+			m_setnames.PUSH_BACK(string("@") + *it);
+		}
+	}
+	return m_setnames;
+}
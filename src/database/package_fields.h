@@ -0,0 +1,87 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#ifndef SRC_DATABASE_PACKAGE_FIELDS_H_
+#define SRC_DATABASE_PACKAGE_FIELDS_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/stringtypes.h"
+
+class Package;
+class PortageSettings;
+
+/**
+Strings derived from the current package of a PackageReader.
+Each is built on first use and then shared by all tests of the package;
+PackageReader::next() forgets them.
+The strings of the versions are in the order of the versions.
+**/
+class PackageFields {
+	public:
+		enum DependKind {
+			DEPEND, RDEPEND, PDEPEND, BDEPEND, IDEPEND
+		};
+		static CONSTEXPR const unsigned int DEPEND_KINDS = 5;
+
+		PackageFields() : m_have(HAVE_NONE) {
+		}
+
+		/**
+		Forget the strings (but keep their capacity)
+		**/
+		void clear() {
+			m_have = HAVE_NONE;
+		}
+
+		/**
+		@return category/name
+		**/
+		ATTRIBUTE_NONNULL_ const std::string& category_name(const Package *pkg);
+
+		/**
+		@return the slots of the versions with "0" for the empty slot
+		**/
+		ATTRIBUTE_NONNULL_ const WordVec& longslots(const Package *pkg);
+
+		/**
+		@return the slots/subslots of the versions
+		**/
+		ATTRIBUTE_NONNULL_ const WordVec& longfullslots(const Package *pkg);
+
+		/**
+		@return the dependency strings of the given kind of the versions
+		**/
+		ATTRIBUTE_NONNULL_ const WordVec& depends(const Package *pkg, DependKind kind);
+
+		/**
+		@return each name of a local set containing pkg, followed by
+		that name with a leading @
+		**/
+		ATTRIBUTE_NONNULL_ const WordVec& setnames(const Package *pkg, const PortageSettings *ps);
+
+	private:
+		typedef unsigned int Have;
+		static CONSTEXPR const Have
+			HAVE_NONE          = 0x00U,
+			HAVE_CATEGORY_NAME = 0x01U,
+			HAVE_LONGSLOTS     = 0x02U,
+			HAVE_LONGFULLSLOTS = 0x04U,
+			HAVE_SETNAMES      = 0x08U,
+			HAVE_DEPEND        = 0x10U;  ///< shifted by DependKind
+		Have m_have;
+
+		std::string m_category_name;
+		WordVec m_longslots, m_longfullslots, m_setnames;
+		WordVec m_depends[DEPEND_KINDS];
+};
+
+#endif  // SRC_DATABASE_PACKAGE_FIELDS_H_
@@ -10,8 +10,15 @@
 #include "database/package_reader.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+
 #include "database/io.h"
+#include "database/trigrams.h"
 #include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
 #include "eixTk/eixint.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
@@ -19,6 +26,37 @@
 #include "portage/package.h"
 #include "portage/version.h"
 
+using std::string;
+using std::vector;
+
+template<class T> class NameLess {
+	public:
+		bool operator()(const T& a, const string& b) const {
+			return (a.name < b);
+		}
+};
+
+template<class T> class KeyLess {
+	public:
+		bool operator()(const T& a, Trigrams::Key b) const {
+			return (a.key < b);
+		}
+};
+
+template<class T> class LengthLess {
+	public:
+		bool operator()(const T& a, const T& b) const {
+			return (a.length < b.length);
+		}
+};
+
+template<class T> class OffsetLess {
+	public:
+		bool operator()(eix::OffsetType a, const T& b) const {
+			return (a < b.offset);
+		}
+};
+
 PackageReader::~PackageReader() {
 	delete m_pkg;
 }
@@ -122,6 +160,9 @@ Package *PackageReader::release() {
 bool PackageReader::next() {
 	if(unlikely(m_cat_size-- == 0)) {
 		if(unlikely(m_frames-- == 0)) {
+			if(m_restricted) {
+				return next_target();
+			}
 			return false;
 		}
 		if(unlikely(!m_db->read_category_header(&m_cat_name, &m_cat_size, &m_errtext))) {
@@ -138,13 +179,321 @@ bool PackageReader::next() {
 	}
 	m_next = m_db->tell() + len;
 	m_have = NONE;
-	delete m_pkg;
-	m_pkg = new Package;
+	m_fields.clear();
+	// Reuse the package (and thus the capacity of its strings)
+	// unless it was released
+	if(likely(m_pkg != NULLPTR)) {
+		m_pkg->recycle();
+	} else {
+		m_pkg = new Package;
+	}
 	m_pkg->category = m_cat_name;
 
 	return true;
 }
 
+bool PackageReader::restrict_to(const Pins& pins) {
+	if(!header->have_index()) {
+		return false;
+	}
+	if(!header->have_trigrams()) {
+		for(Pins::const_iterator it(pins.begin()); likely(it != pins.end()); ++it) {
+			if(!it->trigrams.empty()) {
+				return false;
+			}
+		}
+	}
+	m_restricted = true;
+	m_frames = m_cat_size = 0;
+	m_curr_target = 0;
+	m_targets.clear();
+	if(unlikely(!read_index())) {
+		return true;
+	}
+	for(Pins::const_iterator it(pins.begin()); likely(it != pins.end()); ++it) {
+		if(!it->trigrams.empty()) {
+			if(unlikely(!add_trigram_targets(it->trigrams, it->min_trigrams))) {
+				return true;
+			}
+			continue;
+		}
+		if(it->category.empty()) {
+			for(IndexCategories::size_type i(0); likely(i != m_index.size()); ++i) {
+				if(unlikely(!add_package_target(i, it->name))) {
+					return true;
+				}
+			}
+			continue;
+		}
+		IndexCategories::const_iterator c(std::lower_bound(m_index.begin(),
+			m_index.end(), it->category, NameLess<IndexCategory>()));
+		if((c == m_index.end()) || (c->name != it->category)) {
+			continue;
+		}
+		IndexCategories::size_type i(static_cast<IndexCategories::size_type>(c - m_index.begin()));
+		if(it->name.empty()) {
+			m_targets.PUSH_BACK(Target(c->offset, i, true));
+		} else if(unlikely(!add_package_target(i, it->name))) {
+			return true;
+		}
+	}
+	std::sort(m_targets.begin(), m_targets.end());
+	m_targets.erase(std::unique(m_targets.begin(), m_targets.end()), m_targets.end());
+	// Packages are visited anyway if their whole category is
+	vector<bool> whole(m_index.size(), false);
+	for(Targets::const_iterator it(m_targets.begin()); likely(it != m_targets.end()); ++it) {
+		if(it->whole) {
+			whole[it->category] = true;
+		}
+	}
+	Targets::iterator dest(m_targets.begin());
+	for(Targets::const_iterator it(m_targets.begin()); likely(it != m_targets.end()); ++it) {
+		if(it->whole || !whole[it->category]) {
+			*(dest++) = *it;
+		}
+	}
+	m_targets.erase(dest, m_targets.end());
+	return true;
+}
+
+bool PackageReader::split_categories(vector<Pins> *parts, vector<Pins>::size_type n) {
+	parts->clear();
+	if(!header->have_index() || unlikely(!read_index()) || m_index.empty()) {
+		return false;
+	}
+	// The size of the package table is a good measure for the category size
+	eix::OffsetType total(0);
+	for(IndexCategories::const_iterator it(m_index.begin()); likely(it != m_index.end()); ++it) {
+		total += it->table_length;
+	}
+	// A new part starts when sum/total exceeds the next multiple of 1/n
+	eix::OffsetType sum(0), count(static_cast<eix::OffsetType>(n)), next(total);
+	parts->resize(1);
+	for(IndexCategories::const_iterator it(m_index.begin()); likely(it != m_index.end()); ++it) {
+		if((sum * count >= next) && (parts->size() < n)) {
+			parts->resize(parts->size() + 1);
+			next += total;
+		}
+		parts->back().PUSH_BACK(Pin(it->name, string()));
+		sum += it->table_length;
+	}
+	return true;
+}
+
+bool PackageReader::read_index() {
+	if(m_have_index) {
+		return true;
+	}
+	if(unlikely(!m_db->seekabs(header->index_offset, &m_errtext))) {
+		m_error = true;
+		return false;
+	}
+	m_index.resize(header->size);
+	for(IndexCategories::iterator it(m_index.begin()); likely(it != m_index.end()); ++it) {
+		eix::OffsetType len;
+		if(unlikely(!m_db->read_string(&(it->name), &m_errtext)) ||
+			unlikely(!m_db->read_num(&(it->offset), &m_errtext)) ||
+			unlikely(!m_db->read_num(&len, &m_errtext))) {
+			m_error = true;
+			return false;
+		}
+		// The package table is only read if needed
+		it->table = m_db->tell();
+		it->table_length = len;
+		it->have_packages = false;
+		if(unlikely(!m_db->seekrel(len, &m_errtext))) {
+			m_error = true;
+			return false;
+		}
+	}
+	m_have_index = true;
+	return true;
+}
+
+bool PackageReader::read_index_packages(IndexCategory *cat) {
+	cat->have_packages = true;
+	eix::Catsize size;
+	if(unlikely(!m_db->seekabs(cat->table, &m_errtext)) ||
+		unlikely(!m_db->read_num(&size, &m_errtext))) {
+		m_error = true;
+		return false;
+	}
+	cat->packages.resize(size);
+	for(IndexPackages::iterator it(cat->packages.begin());
+		likely(it != cat->packages.end()); ++it) {
+		if(unlikely(!m_db->read_string(&(it->name), &m_errtext)) ||
+			unlikely(!m_db->read_num(&(it->offset), &m_errtext))) {
+			m_error = true;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool PackageReader::add_package_target(IndexCategories::size_type cat, const string& name) {
+	IndexCategory *c(&(m_index[cat]));
+	if(!c->have_packages) {
+		if(unlikely(!read_index_packages(c))) {
+			m_targets.clear();
+			return false;
+		}
+	}
+	IndexPackages::const_iterator p(std::lower_bound(c->packages.begin(),
+		c->packages.end(), name, NameLess<IndexPackage>()));
+	if((p != c->packages.end()) && (p->name == name)) {
+		m_targets.PUSH_BACK(Target(p->offset, cat, false));
+	}
+	return true;
+}
+
+bool PackageReader::read_trigrams() {
+	m_have_trigrams = true;
+	Trigrams::Index::size_type size;
+	if(unlikely(!m_db->seekabs(header->trigram_offset, &m_errtext)) ||
+		unlikely(!m_db->read_num(&size, &m_errtext))) {
+		m_error = true;
+		return false;
+	}
+	m_trigrams.resize(size);
+	eix::OffsetType postings(0);
+	for(IndexTrigrams::iterator it(m_trigrams.begin()); likely(it != m_trigrams.end()); ++it) {
+		if(unlikely(!m_db->read_num(&(it->key), &m_errtext)) ||
+			unlikely(!m_db->read_num(&(it->length), &m_errtext))) {
+			m_error = true;
+			return false;
+		}
+		it->postings = postings;
+		postings += it->length;
+	}
+	// The postings follow the keys
+	eix::OffsetType start(m_db->tell());
+	for(IndexTrigrams::iterator it(m_trigrams.begin()); likely(it != m_trigrams.end()); ++it) {
+		it->postings += start;
+	}
+	return true;
+}
+
+bool PackageReader::read_postings(const IndexTrigram& trigram, Trigrams::Postings *postings) {
+	Trigrams::Postings::size_type size;
+	if(unlikely(!m_db->seekabs(trigram.postings, &m_errtext)) ||
+		unlikely(!m_db->read_num(&size, &m_errtext))) {
+		m_error = true;
+		return false;
+	}
+	postings->resize(size);
+	eix::OffsetType offset(0);
+	for(Trigrams::Postings::iterator it(postings->begin()); likely(it != postings->end()); ++it) {
+		eix::OffsetType diff;
+		if(unlikely(!m_db->read_num(&diff, &m_errtext))) {
+			m_error = true;
+			return false;
+		}
+		*it = (offset += diff);
+	}
+	return true;
+}
+
+/**
+The candidates are the packages in the postings of at least min keys.
+If these are all keys, start with the shortest postings to keep the
+intersections small; otherwise count the packages in all postings.
+**/
+bool PackageReader::add_trigram_targets(const Trigrams::Keys& keys, Trigrams::Keys::size_type min) {
+	if(!m_have_trigrams && unlikely(!read_trigrams())) {
+		m_targets.clear();
+		return false;
+	}
+	bool need_all(min >= keys.size());
+	IndexTrigrams found;
+	for(Trigrams::Keys::const_iterator k(keys.begin()); likely(k != keys.end()); ++k) {
+		IndexTrigrams::const_iterator t(std::lower_bound(m_trigrams.begin(),
+			m_trigrams.end(), *k, KeyLess<IndexTrigram>()));
+		if((t == m_trigrams.end()) || (t->key != *k)) {
+			if(need_all) {
+				return true;
+			}
+			continue;
+		}
+		found.PUSH_BACK(*t);
+	}
+	if(found.size() < min) {
+		return true;
+	}
+	Trigrams::Postings candidates, postings, common;
+	if(need_all) {
+		std::sort(found.begin(), found.end(), LengthLess<IndexTrigram>());
+		for(IndexTrigrams::const_iterator t(found.begin()); likely(t != found.end()); ++t) {
+			if(unlikely(!read_postings(*t, &postings))) {
+				m_targets.clear();
+				return false;
+			}
+			if(t == found.begin()) {
+				candidates.swap(postings);
+			} else {
+				common.clear();
+				std::set_intersection(candidates.begin(), candidates.end(),
+					postings.begin(), postings.end(), std::back_inserter(common));
+				candidates.swap(common);
+			}
+			if(candidates.empty()) {
+				return true;
+			}
+		}
+	} else {
+		for(IndexTrigrams::const_iterator t(found.begin()); likely(t != found.end()); ++t) {
+			if(unlikely(!read_postings(*t, &postings))) {
+				m_targets.clear();
+				return false;
+			}
+			common.insert(common.end(), postings.begin(), postings.end());
+		}
+		std::sort(common.begin(), common.end());
+		for(Trigrams::Postings::size_type i(0); likely(i != common.size()); ) {
+			Trigrams::Postings::size_type j(i + 1);
+			while((j != common.size()) && (common[j] == common[i])) {
+				++j;
+			}
+			if(j - i >= min) {
+				candidates.PUSH_BACK(common[i]);
+			}
+			i = j;
+		}
+	}
+	for(Trigrams::Postings::const_iterator it(candidates.begin());
+		likely(it != candidates.end()); ++it) {
+		// The category is the last one starting before the package
+		IndexCategories::const_iterator c(std::upper_bound(m_index.begin(),
+			m_index.end(), *it, OffsetLess<IndexCategory>()));
+		if(unlikely(c == m_index.begin())) {
+			continue;
+		}
+		m_targets.PUSH_BACK(Target(*it, static_cast<IndexCategories::size_type>(c - m_index.begin()) - 1, false));
+	}
+	return true;
+}
+
+bool PackageReader::next_target() {
+	if(m_curr_target == m_targets.size()) {
+		m_frames = m_cat_size = 0;
+		return false;
+	}
+	const Target& target(m_targets[m_curr_target++]);
+	if(unlikely(!m_db->seekabs(header->tree_offset + target.offset, &m_errtext))) {
+		m_error = true;
+		return false;
+	}
+	if(target.whole) {
+		m_frames = 1;
+		m_cat_size = 0;
+	} else {
+		// We seek directly to the package and skip the category header
+		m_cat_name = m_index[target.category].name;
+		m_frames = 0;
+		m_cat_size = 1;
+	}
+	return next();
+}
+
 #if 0
 bool PackageReader::nextCategory() {
 	if(unlikely(m_frames-- == 0)) {
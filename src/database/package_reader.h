@@ -16,8 +16,12 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "database/header.h"
+#include "database/package_fields.h"
+#include "database/trigrams.h"
+#include "eixTk/attribute.h"
 #include "eixTk/eixint.h"
 #include "eixTk/null.h"
 
@@ -37,16 +41,39 @@ class PackageReader {
 			ALL = 7
 		};
 
+		/**
+		A restriction for the packages to be read: An empty name means
+		the whole category, an empty category means the name in every
+		category. If trigrams is nonempty, it means instead all packages
+		containing at least min_trigrams of these trigrams.
+		**/
+		class Pin {
+			public:
+				std::string category, name;
+				Trigrams::Keys trigrams;
+				Trigrams::Keys::size_type min_trigrams;
+
+				Pin(const std::string& cat, const std::string& pkg) : category(cat), name(pkg), min_trigrams(0) {
+				}
+
+				explicit Pin(const Trigrams::Keys& keys) : trigrams(keys), min_trigrams(keys.size()) {
+				}
+
+				Pin(const Trigrams::Keys& keys, Trigrams::Keys::size_type min) : trigrams(keys), min_trigrams(min) {
+				}
+		};
+		typedef std::vector<Pin> Pins;
+
 		/**
 		Initialize with file-stream and number of packages.
 		@arg ps is used to define the local package sets while version reading
 		**/
 		PackageReader(Database *db, const DBHeader& hdr, PortageSettings *ps)
-			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(ps), m_error(false) {
+			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(ps), m_error(false), m_have_index(false), m_have_trigrams(false), m_restricted(false) {
 		}
 
 		PackageReader(Database *db, const DBHeader& hdr)
-			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(NULLPTR), m_error(false) {
+			: m_db(db), m_frames(hdr.size), m_cat_size(0), m_pkg(NULLPTR), header(&hdr), m_portagesettings(NULLPTR), m_error(false), m_have_index(false), m_have_trigrams(false), m_restricted(false) {
 		}
 
 		~PackageReader();
@@ -86,6 +113,21 @@ class PackageReader {
 		**/
 		bool next();
 
+		/**
+		Let next() only visit the packages matching one of pins, using
+		the index of the cachefile. Must be called before the first next().
+		@return false if the cachefile has no (trigram) index needed for pins;
+		nothing is changed then.
+		**/
+		bool restrict_to(const Pins& pins);
+
+		/**
+		Split the categories into at most n parts of roughly equal size
+		(using the index of the cachefile), each described by pins.
+		@return false if the cachefile has no index
+		**/
+		ATTRIBUTE_NONNULL_ bool split_categories(std::vector<Pins> *parts, std::vector<Pins>::size_type n);
+
 #if 0
 		/**
 		Go into the next (or first) category part.
@@ -111,6 +153,13 @@ class PackageReader {
 			return (m_error ? m_errtext.c_str() : NULLPTR);
 		}
 
+		/**
+		@return the strings derived from the current package
+		**/
+		PackageFields *fields() {
+			return &m_fields;
+		}
+
 	protected:
 		Database         *m_db;
 
@@ -127,6 +176,70 @@ class PackageReader {
 
 		std::string m_errtext;
 		bool m_error;
+
+		PackageFields m_fields;
+
+	private:
+		class IndexPackage {
+			public:
+				std::string name;
+				eix::OffsetType offset;
+		};
+		typedef std::vector<IndexPackage> IndexPackages;
+
+		class IndexCategory {
+			public:
+				std::string name;
+				eix::OffsetType offset, table, table_length;
+				bool have_packages;
+				IndexPackages packages;
+		};
+		typedef std::vector<IndexCategory> IndexCategories;
+
+		class IndexTrigram {
+			public:
+				Trigrams::Key key;
+				eix::OffsetType postings, length;
+		};
+		typedef std::vector<IndexTrigram> IndexTrigrams;
+
+		/**
+		A place to seek to: A whole category or a single package of it
+		**/
+		class Target {
+			public:
+				eix::OffsetType offset;
+				IndexCategories::size_type category;
+				bool whole;
+
+				Target(eix::OffsetType off, IndexCategories::size_type cat, bool all) : offset(off), category(cat), whole(all) {
+				}
+
+				bool operator<(const Target& t) const {
+					return (offset < t.offset);
+				}
+
+				bool operator==(const Target& t) const {
+					return (offset == t.offset);
+				}
+		};
+		typedef std::vector<Target> Targets;
+
+		IndexCategories m_index;
+		bool m_have_index;
+		IndexTrigrams m_trigrams;
+		bool m_have_trigrams;
+		Targets m_targets;
+		Targets::size_type m_curr_target;
+		bool m_restricted;
+
+		bool read_index();
+		bool read_index_packages(IndexCategory *cat);
+		bool add_package_target(IndexCategories::size_type cat, const std::string& name);
+		bool read_trigrams();
+		ATTRIBUTE_NONNULL_ bool read_postings(const IndexTrigram& trigram, Trigrams::Postings *postings);
+		bool add_trigram_targets(const Trigrams::Keys& keys, Trigrams::Keys::size_type min);
+		bool next_target();
 };
 
 #endif  // SRC_DATABASE_PACKAGE_READER_H_
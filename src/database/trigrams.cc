@@ -0,0 +1,66 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#include "database/trigrams.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <algorithm>
+#include <string>
+
+#include "eixTk/eixint.h"
+#include "eixTk/likely.h"
+#include "portage/package.h"
+
+using std::string;
+
+bool Trigrams::save_trigrams = true;
+
+/**
+@return the lowercased ASCII character or 0 if c is not ASCII
+**/
+inline static Trigrams::Key trigram_char(char c) {
+	eix::UChar u(static_cast<eix::UChar>(c));
+	if(unlikely(u >= 0x80U)) {
+		return 0;
+	}
+	if((u >= 'A') && (u <= 'Z')) {
+		u = static_cast<eix::UChar>(u + ('a' - 'A'));
+	}
+	return Trigrams::Key(u);
+}
+
+void Trigrams::add(Keys *keys, const string& s) {
+	string::size_type len(s.size());
+	if(len < 3) {
+		return;
+	}
+	Key key(0);
+	// Number of valid characters at the end of key
+	unsigned int valid(0);
+	for(string::size_type i(0); likely(i != len); ++i) {
+		Key c(trigram_char(s[i]));
+		if(unlikely(c == 0)) {
+			valid = 0;
+			continue;
+		}
+		key = ((key << 8) | c) & 0xFFFFFFU;
+		if(++valid >= 3) {
+			keys->push_back(key);
+		}
+	}
+}
+
+void Trigrams::add(Keys *keys, const Package& pkg) {
+	add(keys, pkg.category + "/" + pkg.name);
+	add(keys, pkg.desc);
+	add(keys, pkg.homepage);
+}
+
+void Trigrams::normalize(Keys *keys) {
+	std::sort(keys->begin(), keys->end());
+	keys->erase(std::unique(keys->begin(), keys->end()), keys->end());
+}
@@ -0,0 +1,60 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#ifndef SRC_DATABASE_TRIGRAMS_H_
+#define SRC_DATABASE_TRIGRAMS_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "eixTk/eixint.h"
+
+class Package;
+
+/**
+Trigrams of the strings searched for NAME, DESCRIPTION, CATEGORY,
+CATEGORY_NAME, and HOMEPAGE. They are used to find candidates for
+substring-like searches without reading every package.
+Only trigrams of ASCII characters are used, and these are lowercased,
+so that the candidates are a superset also for case-insensitive matching.
+**/
+class Trigrams {
+	public:
+		/**
+		The three characters of the trigram in the lowest three bytes
+		**/
+		typedef eix::UNumber Key;
+		typedef std::vector<Key> Keys;
+		typedef std::vector<eix::OffsetType> Postings;
+		typedef std::map<Key, Postings> Index;
+
+		/**
+		Whether eix-update should store the trigrams in the cachefile
+		**/
+		static bool save_trigrams;
+
+		/**
+		Append the trigrams of s; keys is not sorted
+		**/
+		ATTRIBUTE_NONNULL_ static void add(Keys *keys, const std::string& s);
+
+		/**
+		Append the trigrams of the indexed fields of pkg; keys is not sorted
+		**/
+		ATTRIBUTE_NONNULL_ static void add(Keys *keys, const Package& pkg);
+
+		/**
+		Sort keys and remove duplicates
+		**/
+		ATTRIBUTE_NONNULL_ static void normalize(Keys *keys);
+};
+
+#endif  // SRC_DATABASE_TRIGRAMS_H_
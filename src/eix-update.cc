@@ -13,17 +13,25 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include <string>
 #include <vector>
 
+#include "cache/base.h"
 #include "cache/cachetable.h"
+#include "cache/parallel_read.h"
 #include "database/header.h"
 #include "database/io.h"
+#include "database/package_reader.h"
+#include "database/trigrams.h"
 #include "eixTk/attribute.h"
 #include "eixTk/argsreader.h"
 #include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
 #include "eixTk/filenames.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
@@ -42,8 +50,11 @@
 #include "portage/conf/portagesettings.h"
 #include "portage/depend.h"
 #include "portage/extendedversion.h"
+#include "portage/keywords.h"
 #include "portage/overlay.h"
+#include "portage/package.h"
 #include "portage/packagetree.h"
+#include "portage/version.h"
 #include "various/drop_permissions.h"
 
 using std::string;
@@ -100,8 +111,11 @@ typedef vector<Override> Overrides;
 typedef vector<RepoName> RepoNames;
 
 static void print_help();
-ATTRIBUTE_NONNULL_ static bool update(const char *outputfile, CacheTable *cache_table, PortageSettings *portage_settings, bool override_umask, const RepoNames& repo_names, const WordVec& exclude_labels, Statusline *statusline, string *errtext);
+ATTRIBUTE_NONNULL_ static bool update(const char *outputfile, CacheTable *cache_table, PortageSettings *portage_settings, bool override_umask, const RepoNames& repo_names, const WordVec& exclude_labels, bool incremental, unsigned int jobs, const string& tmpdir, Statusline *statusline, string *errtext);
+ATTRIBUTE_NONNULL_ static void calc_stamps(CacheStampsVec *stamps, const CacheTable& cache_table, const PackageTree& package_tree);
+ATTRIBUTE_NONNULL_ static void reuse_categories(WordSet *reused, const char *outputfile, const DBHeader& dbheader, PackageTree *package_tree);
 static void error_callback(const string& str);
+static void category_callback(const string& cat_name, bool found);
 ATTRIBUTE_NONNULL_ static void add_pathnames(PathVec *add_list, const WordVec& to_add, bool must_resolve);
 ATTRIBUTE_NONNULL_ static void add_override(Overrides *override_list, EixRc *eixrc, const char *s);
 ATTRIBUTE_NONNULL_ static void add_reponames(RepoNames *repo_names, EixRc *eixrc, const char *s);
@@ -123,6 +137,7 @@ static void print_help() {
 "     --force-status      always output status line\n"
 " -F, --force-color       force \"color\" even if output is no terminal\n"
 " -v, --verbose           output used cache method for each ebuild\n"
+"                         and the peak memory usage\n"
 "\n"
 " -q, --quiet             produce no output\n"
 "\n"
@@ -312,6 +327,8 @@ int run_eix_update(int argc, char *argv[]) {
 	Depend::use_depend = eixrc.getBool("DEP");
 	Version::use_required_use = eixrc.getBool("REQUIRED_USE");
 	ExtendedVersion::use_src_uri = eixrc.getBool("SRC_URI");
+	File::use_mmap = eixrc.getBool("MMAP_CACHEFILE");
+	Trigrams::save_trigrams = eixrc.getBool("SAVE_TRIGRAMS");
 	string eix_cachefile(eixrc["EIX_CACHEFILE"]); {
 	/* calculate defaults for use_{percentage,status} */
 		bool percentage_tty(false);
@@ -542,8 +559,19 @@ int run_eix_update(int argc, char *argv[]) {
 
 	/* Update the database from scratch */
 	string errtext;
+	unsigned int jobs(eixrc.getInteger("PARALLEL_UPDATE"));
+	if(jobs == 0) {
+		jobs = count_processors();
+	}
+	if(eixrc.getBool("PREFETCH_CACHE")) {
+		for(CacheTable::iterator it(table.begin());
+			likely(it != table.end()); ++it) {
+			(*it)->setPrefetch();
+		}
+	}
 	if(unlikely(!update(outputfile.c_str(), &table, &portage_settings, override_umask,
-			repo_names, excluded_overlays, &statusline, &errtext))) {
+			repo_names, excluded_overlays, eixrc.getBool("INCREMENTAL_UPDATE"),
+			jobs, eixrc["EIX_TMPDIR"], &statusline, &errtext))) {
 		eix::say_error() % errtext;
 		statusline.failure();
 		return EXIT_FAILURE;
@@ -558,7 +586,129 @@ static void error_callback(const string& str) {
 	reading_percent_status->interprint_end();
 }
 
-static bool update(const char *outputfile, CacheTable *cache_table, PortageSettings *portage_settings, bool override_umask, const RepoNames& repo_names, const WordVec& exclude_labels, Statusline *statusline, string *errtext) {
+static void category_callback(const string& cat_name, bool found) {
+	if(use_percentage) {
+		if(found) {
+			reading_percent_status->next(eix::format(P_("Percent", ": %s...")) % cat_name);
+		} else {
+			reading_percent_status->next();
+		}
+	}
+}
+
+/**
+Calculate the stamps of all categories of all caches
+**/
+static void calc_stamps(CacheStampsVec *stamps, const CacheTable& cache_table, const PackageTree& package_tree) {
+	for(CacheTable::const_iterator it(cache_table.begin());
+		likely(it != cache_table.end()); ++it) {
+		BasicCache *cache(*it);
+		stamps->PUSH_BACK(CacheStamps());
+		if(cache->can_read_multiple_categories()) {
+			continue;
+		}
+		CacheStamps& cache_stamps(stamps->back());
+		bool supported(true);
+		for(PackageTree::const_iterator c(package_tree.begin());
+			likely(c != package_tree.end()); ++c) {
+			if(!cache->get_category_stamp(&(cache_stamps.categories[c->first]), c->first.c_str())) {
+				supported = false;
+				break;
+			}
+		}
+		if(supported) {
+			cache_stamps.type = cache->getType();
+		} else {
+			cache_stamps.categories.clear();
+		}
+	}
+}
+
+/**
+Read those categories from the previous database outputfile for which
+all caches support stamps and none of the stamps has changed.
+The database must have been written with the same overlays and options.
+**/
+static void reuse_categories(WordSet *reused, const char *outputfile, const DBHeader& dbheader, PackageTree *package_tree) {
+	Database db;
+	if(!db.openread(outputfile)) {
+		return;
+	}
+	DBHeader header;
+	string errtext;
+	if(!db.read_header(&header, &errtext, DBHeader::current)) {
+		return;
+	}
+	if((header.use_depend != Depend::use_depend) ||
+		(header.use_required_use != Version::use_required_use) ||
+		(header.use_src_uri != ExtendedVersion::use_src_uri) ||
+		(header.countOverlays() != dbheader.countOverlays())) {
+		return;
+	}
+	for(ExtendedVersion::Overlay i(0); likely(i != header.countOverlays()); ++i) {
+		const OverlayIdent& old_overlay(header.getOverlay(i));
+		const OverlayIdent& overlay(dbheader.getOverlay(i));
+		if((old_overlay.path != overlay.path) || (old_overlay.label != overlay.label)) {
+			return;
+		}
+	}
+	CacheStampsVec stamps;
+	if(!db.read_stamps(header, &stamps, &errtext) ||
+		(stamps.size() != dbheader.stamps.size())) {
+		return;
+	}
+	PackageReader::Pins pins;
+	for(PackageTree::const_iterator c(package_tree->begin());
+		likely(c != package_tree->end()); ++c) {
+		bool unchanged(true);
+		for(CacheStampsVec::size_type i(0); likely(i != stamps.size()); ++i) {
+			const CacheStamps& old_stamps(stamps[i]);
+			const CacheStamps& new_stamps(dbheader.stamps[i]);
+			if(old_stamps.type.empty() || (old_stamps.type != new_stamps.type)) {
+				return;
+			}
+			CacheStamps::Categories::const_iterator old_stamp(old_stamps.categories.find(c->first));
+			if((old_stamp == old_stamps.categories.end()) ||
+				(old_stamp->second != new_stamps.categories.find(c->first)->second)) {
+				unchanged = false;
+				break;
+			}
+		}
+		if(unchanged) {
+			reused->INSERT(c->first);
+			pins.PUSH_BACK(PackageReader::Pin(c->first, string()));
+		}
+	}
+	if(pins.empty()) {
+		return;
+	}
+	PackageReader reader(&db, header);
+	if(!reader.restrict_to(pins)) {
+		reused->clear();
+		return;
+	}
+	while(likely(reader.next())) {
+		Package *p(reader.release());
+		if(unlikely(p == NULLPTR)) {
+			break;
+		}
+		// The masks are applied anew
+		for(Package::iterator v(p->begin()); likely(v != p->end()); ++v) {
+			v->maskflags.set(MaskFlags::MASK_NONE);
+		}
+		(*package_tree)[p->category].addPackage(p);
+	}
+	if(unlikely(reader.get_errtext() != NULLPTR)) {
+		// Read everything from scratch
+		for(WordSet::const_iterator it(reused->begin());
+			likely(it != reused->end()); ++it) {
+			(*package_tree)[*it].delete_and_clear();
+		}
+		reused->clear();
+	}
+}
+
+static bool update(const char *outputfile, CacheTable *cache_table, PortageSettings *portage_settings, bool override_umask, const RepoNames& repo_names, const WordVec& exclude_labels, bool incremental, unsigned int jobs, const string& tmpdir, Statusline *statusline, string *errtext) {
 	DBHeader dbheader;
 	WordVec categories;
 	portage_settings->pushback_categories(&categories);
@@ -597,7 +747,30 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 		++it;
 	}
 
-	/* Build database from scratch. */
+	/* For an incremental update, reuse the unchanged categories. */
+	WordVec read_categories;
+	{
+		WordSet reused;
+		if(incremental) {
+			dbheader.use_stamps = true;
+			calc_stamps(&(dbheader.stamps), *cache_table, package_tree);
+			reuse_categories(&reused, outputfile, dbheader, &package_tree);
+			if(!reused.empty()) {
+				INFO(N_("Reusing %s unchanged category from %s",
+					"Reusing %s unchanged categories from %s",
+					reused.size()))
+					% reused.size() % outputfile;
+			}
+		}
+		for(PackageTree::const_iterator c(package_tree.begin());
+			likely(c != package_tree.end()); ++c) {
+			if(reused.count(c->first) == 0) {
+				read_categories.PUSH_BACK(c->first);
+			}
+		}
+	}
+
+	/* Build database from scratch (except for reused categories). */
 	for(CacheTable::iterator it(cache_table->begin());
 		likely(it != cache_table->end()); ++it) {
 		BasicCache *cache(*it);
@@ -622,34 +795,42 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 			if(use_percentage) {
 				reading_percent_status->init(P_("Percent",
 					"     Reading category %s|%s (%s%%)"),
-					package_tree.size());
+					read_categories.size());
 			} else {
 				reading_percent_status->init(eix::format(NP_("Percent",
 					"     Reading %s category of packages...",
 					"     Reading up to %s categories of packages...",
-					package_tree.size()))
-					% package_tree.size());
+					read_categories.size()))
+					% read_categories.size());
 			}
 
 			/* iterator through categories */
 			bool aborted(false);
-			bool is_empty(true);
-			for(PackageTree::const_iterator ci(package_tree.begin());
-				unlikely(ci != package_tree.end()); ++ci) {
-				if(!cache->readCategoryPrepare(ci->first.c_str())) {
-					if(use_percentage) {
-						reading_percent_status->next();
-					}
-				} else {
-					if(use_percentage) {
-						reading_percent_status->next(eix::format(P_("Percent", ": %s...")) % ci->first);
-					}
-					is_empty = false;
-					if(!cache->readCategory(ci->second)) {
-						aborted = true;
+			// If all categories are reused, this is not an empty cache
+			bool is_empty(!read_categories.empty());
+			// The progress of a failed parallel read is not shown again
+			WordSet reported;
+			if(verbose || !parallel_read(cache, &package_tree, read_categories,
+				dbheader, jobs, tmpdir, category_callback, error_callback,
+				&is_empty, &aborted, &reported)) {
+				for(WordVec::const_iterator ci(read_categories.begin());
+					unlikely(ci != read_categories.end()); ++ci) {
+					bool show(use_percentage && (reported.count(*ci) == 0));
+					if(!cache->readCategoryPrepare(ci->c_str())) {
+						if(show) {
+							reading_percent_status->next();
+						}
+					} else {
+						if(show) {
+							reading_percent_status->next(eix::format(P_("Percent", ": %s...")) % *ci);
+						}
+						is_empty = false;
+						if(!cache->readCategory(package_tree.find(*ci))) {
+							aborted = true;
+						}
 					}
+					cache->readCategoryFinalize();
 				}
-				cache->readCategoryFinalize();
 			}
 			string msg(unlikely(is_empty) ? P_("Percent", "EMPTY!") :
 				(unlikely(aborted) ? P_("Percent", "ABORTED!") :
@@ -661,6 +842,12 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 		}
 		delete reading_percent_status;
 	}
+	if(BasicCache::files_read != 0) {
+		INFO(N_("Read %s cache file (%s bytes)",
+			"Read %s cache files (%s bytes)",
+			BasicCache::files_read))
+			% BasicCache::files_read % BasicCache::bytes_read;
+	}
 	statusline->print(P_("Statusline eix-update", "Analyzing"));
 
 	/* Now apply all masks... */
@@ -686,17 +873,24 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 	/* And write database back to disk... */
 	statusline->print(eix::format(P_("Statusline eix-update", "Creating %s")) % outputfile);
 	INFO(_("Writing database file %s...")) % outputfile;
+	// Write a temporary file and rename it, so that readers which are
+	// still using (e.g. have mapped) the old file are not disturbed
+	string target(normalize_path(outputfile, true));
+	struct stat st;
+	bool have_target(stat(target.c_str(), &st) == 0);
+	bool use_tmp(!have_target || S_ISREG(st.st_mode));
+	string writefile(use_tmp ? string(eix::format("%s.%s") % target % getpid()) : target);
 	mode_t old_umask;
 	if(override_umask) {
 		old_umask = umask(2);
 	}
 	Database db;
-	bool ok(db.openwrite(outputfile));
+	bool ok(db.openwrite(writefile.c_str()));
 	if(override_umask) {
 		umask(old_umask);
 	}
 	if(unlikely(!ok)) {
-		*errtext = eix::format(_("cannot open database file %s for writing (mode = 'wb')")) % outputfile;
+		*errtext = eix::format(_("cannot open database file %s for writing (mode = 'wb')")) % writefile;
 		return false;
 	}
 
@@ -704,12 +898,39 @@ static bool update(const char *outputfile, CacheTable *cache_table, PortageSetti
 
 	if(!(likely(db.write_header(dbheader, errtext)) &&
 		likely(db.write_packagetree(package_tree, dbheader, errtext)))) {
+		db.close();
+		if(use_tmp) {
+			std::remove(writefile.c_str());
+		}
+		return false;
+	}
+	if(unlikely(!db.close())) {
+		Database::writeError(errtext);
+		if(use_tmp) {
+			std::remove(writefile.c_str());
+		}
 		return false;
 	}
+	if(use_tmp) {
+		if(have_target) {
+			// Keep the permissions of the previous file
+			chmod(writefile.c_str(), st.st_mode & 07777);
+		}
+		if(unlikely(std::rename(writefile.c_str(), target.c_str()) != 0)) {
+			*errtext = eix::format(_("cannot write %s: %s")) % target % std::strerror(errno);
+			std::remove(writefile.c_str());
+			return false;
+		}
+	}
 
 	INFO(N_("Database contains %s packages in %s category",
 		"Database contains %s packages in %s categories",
 		dbheader.size))
 		% package_tree.countPackages() % dbheader.size;
+	eix::UNumber peak;
+	if(verbose && get_peak_memory(&peak)) {
+		INFO(_("Peak memory usage: %s KiB"))
+			% peak;
+	}
 	return true;
 }
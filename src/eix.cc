@@ -8,13 +8,22 @@
 //   Martin Väth <martin@mvath.de>
 
 #include <config.h>  // IWYU pragma: keep
+#ifndef PACKAGE_VERSION
+#include <config_vers.h>
+#endif
 
+#include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
+#include <cerrno>
+#include <csignal>
 #include <cstdlib>
 #include <cstring>
 
 #include <algorithm>
+#include <fstream>
+#include <iostream>
 #include <string>
 #include <vector>
 
@@ -37,6 +46,7 @@
 #include "eixTk/ptr_container.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/sysutils.h"
 #include "eixTk/unordered_map.h"
 #include "eixTk/utils.h"
 #include "eixrc/eixrc.h"
@@ -52,15 +62,20 @@
 #include "portage/extendedversion.h"
 #include "portage/keywords.h"
 #include "portage/mask.h"
+#include "portage/mask_list.h"
 #include "portage/package.h"
 #include "portage/packagetree.h"
 #include "portage/set_stability.h"
+#include "portage/stability_cache.h"
 #include "portage/vardbpkg.h"
 #include "search/algorithms.h"
+#include "search/levenshtein.h"
 #include "search/matchtree.h"
+#include "search/parallel_scan.h"
 #include "search/packagetest.h"
 #include "various/cli.h"
 #include "various/drop_permissions.h"
+#include "various/server.h"
 
 #define VAR_DB_PKG "/var/db/pkg/"
 
@@ -81,6 +96,14 @@ ATTRIBUTE_NONNULL_ static bool is_current_dbversion(const char *filename, const
 static void print_wordvec(const WordVec& vec);
 static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist, bool test_empty);
 static void print_removed(const string& dirname, const string& excludefiles, const PackageList& packagelist);
+ATTRIBUTE_NONNULL_ static int run_batch(EixRc *eixrc, Database *db, DBHeader *header, PortageSettings *portagesettings, VarDbPkg *varpkg_db, SetStability *stability);
+ATTRIBUTE_NONNULL_ static void get_stability_key(string *key, EixRc *eixrc, const PortageSettings& portagesettings, const string& cachefile);
+static void save_stability_cache(const SetStability& stability);
+class Resident;
+ATTRIBUTE_NONNULL((1, 3)) static int run_eix_query(EixRc *eixrc, int argc, char **argv, Resident *server);
+ATTRIBUTE_NONNULL_ static int run_server(EixRc *eixrc, Resident *resident, const char *program);
+ATTRIBUTE_NONNULL_ static int run_eix_client(int argc, char **argv);
+ATTRIBUTE_NONNULL_ static void sort_matches(PackageList *matches, vector<eix::UNumber> *keys, const vector<Package *>& unsorted, PackageList::size_type begin, PackageList::size_type end);
 inline static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist);
 inline static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist) {
 	print_unused(filename, excludefiles, packagelist, false);
@@ -138,6 +161,12 @@ static void dump_help() {
 "         --care            always read slots of installed packages\n"
 "         --deps-installed  always read deps of installed packages\n"
 "         --cache-file      use another cache-file instead of %s\n"
+"         --batch FILE      read a query from each line of FILE (- is stdin)\n"
+"                           and output the results grouped by query\n"
+"         --server SOCKET   keep the data in memory and answer queries of\n"
+"                           clients at the unix socket SOCKET\n"
+"         --client SOCKET   (must be the first option) let the server at\n"
+"                           SOCKET answer the query given by the other options\n"
 "     -R  --remote (toggle)  use remote cache-file %s\n"
 "     -Z  --remote2 (toggle) use remote cache-file %s\n"
 "\n"
@@ -283,6 +312,8 @@ static void dump_help() {
 
 static const char *formatstring;
 static const char *eix_cachefile(NULLPTR);
+static const char *batch_file(NULLPTR);
+static const char *server_socket(NULLPTR);
 static const char *var_to_print(NULLPTR);
 static const char *color(NULLPTR);
 
@@ -417,6 +448,8 @@ EixOptionList::EixOptionList() {
 	push_back(Option("format",         O_FMT,         Option::STRING,   &formatstring));
 
 	push_back(Option("cache-file",     O_EIX_CACHEFILE, Option::STRING, &eix_cachefile));
+	push_back(Option("batch",          O_BATCH,         Option::STRING, &batch_file));
+	push_back(Option("server",         O_SERVER,        Option::STRING, &server_socket));
 	push_back(Option("remote",         'R', Option::BOOLEAN, &rc_options.remote));
 	push_back(Option("remote2",        'Z', Option::BOOLEAN, &rc_options.remote2));
 
@@ -549,6 +582,7 @@ static void setup_defaults(EixRc *rc, bool is_tty) {
 	Depend::use_depend           = rc->getBool("DEP");
 	Version::use_required_use    = rc->getBool("REQUIRED_USE");
 	ExtendedVersion::use_src_uri = rc->getBool("SRC_URI");
+	File::use_mmap               = rc->getBool("MMAP_CACHEFILE");
 
 	rc_options.quick           = rc->getBool("QUICKMODE");
 	rc_options.be_quiet        = rc->getBool("QUIETMODE");
@@ -569,6 +603,11 @@ static void setup_defaults(EixRc *rc, bool is_tty) {
 	}
 
 	formatstring               = NULLPTR;
+	eix_cachefile              = NULLPTR;
+	batch_file                 = NULLPTR;
+	server_socket              = NULLPTR;
+	var_to_print               = NULLPTR;
+	color                      = NULLPTR;
 	format->setupResources(rc);
 	format->no_color            = (rc->getBool("NOCOLORS") ? true :
 		(rc->getBool("FORCE_COLORS") ? false : (!is_tty)));
@@ -651,7 +690,63 @@ static void set_format(EixRc *rc) {
 	}
 }
 
+/**
+The data which eix --server keeps in memory for its queries
+**/
+class Resident {
+	public:
+		string cachefile;
+		bool quick, care, deps_installed;
+		PortageSettings *portagesettings;
+		VarDbPkg *varpkg_db;
+		Database db;
+		DBHeader header;
+
+		/**
+		The position after the header for reopening an unmapped database
+		**/
+		eix::OffsetType db_offset;
+
+		Resident() : portagesettings(NULLPTR), varpkg_db(NULLPTR) {
+		}
+
+		~Resident() {
+			delete varpkg_db;
+			delete portagesettings;
+		}
+
+		/**
+		@return true if the current options can use this data
+		**/
+		bool fits(const string& file) const {
+			return ((file == cachefile) && (quick == rc_options.quick) &&
+				(care == rc_options.care) &&
+				(deps_installed == rc_options.deps_installed) &&
+				!rc_options.print_profile_paths);
+		}
+};
+
+/**
+Returned by run_server if the resident data has to be read anew
+**/
+static const int RELOAD_SERVER = -1;
+
+/**
+Whether we are a process answering a query of eix --server
+**/
+static bool in_server(false);
+
+/**
+The listening socket of eix --server; it is kept when the data is reloaded
+**/
+static int server_fd(-1);
+
 int run_eix(int argc, char** argv) {
+	// The client only forwards its arguments, so it need not read anything
+	if(unlikely((argc > 1) && (std::strcmp(argv[1], "--client") == 0))) {
+		return run_eix_client(argc, argv);
+	}
+
 	// Initialize static classes
 	Eapi::init_static();
 	Category::init_static();
@@ -672,6 +767,19 @@ int run_eix(int argc, char** argv) {
 		}
 	}
 
+	int ret;
+	while((ret = run_eix_query(&eixrc, argc, argv, NULLPTR)) == RELOAD_SERVER) {
+	}
+	return ret;
+}
+
+/**
+Evaluate the query of the command line, either from scratch
+or using the data of server (if it is not NULLPTR)
+**/
+static int run_eix_query(EixRc *eixrcp, int argc, char **argv, Resident *server) {
+	EixRc& eixrc(*eixrcp);
+
 	// Setup defaults for all global variables like rc_options
 	bool is_tty(isatty(1) != 0);
 	setup_defaults(&eixrc, is_tty);
@@ -809,39 +917,60 @@ int run_eix(int argc, char** argv) {
 	}
 
 	parse_error = new ParseError(rc_options.no_warn);
-	PortageSettings portagesettings(&eixrc, parse_error, true, false, rc_options.print_profile_paths);
-	if(unlikely(rc_options.print_profile_paths)) {
-		return EXIT_SUCCESS;
-	}
-
 	string var_db_pkg(eixrc["EPREFIX_INSTALLED"] + VAR_DB_PKG);
-	VarDbPkg varpkg_db(var_db_pkg, !rc_options.quick, rc_options.care,
-		rc_options.deps_installed,
-		eixrc.getBool("RESTRICT_INSTALLED"),
-		eixrc.getBool("CARE_RESTRICT_INSTALLED"),
-		eixrc.getBool("USE_BUILD_TIME"));
-	varpkg_db.check_installed_overlays = eixrc.getBoolText("CHECK_INSTALLED_OVERLAYS", "repository");
+	Resident local;
+	Resident *resident(&local);
+	if((server != NULLPTR) && server->fits(cachefile)) {
+		resident = server;
+	} else {
+		local.portagesettings = new PortageSettings(&eixrc, parse_error, true, false, rc_options.print_profile_paths);
+		if(unlikely(rc_options.print_profile_paths)) {
+			return EXIT_SUCCESS;
+		}
 
-	MaskList<Mask> *marked_list(NULLPTR);
+		local.varpkg_db = new VarDbPkg(var_db_pkg, !rc_options.quick, rc_options.care,
+			rc_options.deps_installed,
+			eixrc.getBool("RESTRICT_INSTALLED"),
+			eixrc.getBool("CARE_RESTRICT_INSTALLED"),
+			eixrc.getBool("USE_BUILD_TIME"));
+		local.varpkg_db->check_installed_overlays = eixrc.getBoolText("CHECK_INSTALLED_OVERLAYS", "repository");
 
-	/* Open database file */
-	Database db;
-	if(unlikely(!opencache(&db, cachefile.c_str(), tooltext))) {
-		return EXIT_FAILURE;
-	}
-	DBHeader header;
+		/* Open database file */
+		if(unlikely(!opencache(&local.db, cachefile.c_str(), tooltext))) {
+			return EXIT_FAILURE;
+		}
 
-	if(unlikely(!db.read_header(&header, NULLPTR, 0))) {
-		eix::say_error(_(
-			"%s was created with an incompatible eix-update:\n"
-			"It uses database format %s (current is %s).\n"
-			"Please run \"%s\" and try again."))
-			% cachefile
-			% header.version % DBHeader::current
-			% tooltext;
-		return EXIT_FAILURE;
+		if(unlikely(!local.db.read_header(&local.header, NULLPTR, 0))) {
+			eix::say_error(_(
+				"%s was created with an incompatible eix-update:\n"
+				"It uses database format %s (current is %s).\n"
+				"Please run \"%s\" and try again."))
+				% cachefile
+				% local.header.version % DBHeader::current
+				% tooltext;
+			return EXIT_FAILURE;
+		}
+		local.db_offset = local.db.tell();
+		local.cachefile = cachefile;
+		local.quick = rc_options.quick;
+		local.care = rc_options.care;
+		local.deps_installed = rc_options.deps_installed;
+	}
+	PortageSettings& portagesettings(*(resident->portagesettings));
+	VarDbPkg& varpkg_db(*(resident->varpkg_db));
+	Database& db(resident->db);
+	DBHeader& header(resident->header);
+
+	if(unlikely(server_socket != NULLPTR)) {
+		if(unlikely(in_server)) {
+			eix::say_error(_("--server cannot be used in a query to a server"));
+			return EXIT_FAILURE;
+		}
+		return run_server(&eixrc, &local, argv[0]);
 	}
 
+	MaskList<Mask> *marked_list(NULLPTR);
+
 	if(unlikely(rc_options.hash_eapi)) {
 		header.eapi_hash.output();
 		return EXIT_SUCCESS;
@@ -897,23 +1026,65 @@ int run_eix(int argc, char** argv) {
 	}
 
 	SetStability stability(&portagesettings, !rc_options.ignore_etc_portage, false, eixrc.getBool("ALWAYS_ACCEPT_KEYWORDS"));
+	StabilityCache stability_cache;
+	const string& stability_cachefile(eixrc["STABILITY_CACHEFILE"]);
+	if(unlikely(!stability_cachefile.empty())) {
+		string key;
+		get_stability_key(&key, &eixrc, portagesettings, cachefile);
+		stability_cache.init(stability_cachefile, key);
+		stability.set_cache(&stability_cache);
+	}
+
+	if(unlikely(batch_file != NULLPTR)) {
+		return run_batch(&eixrc, &db, &header, &portagesettings, &varpkg_db, &stability);
+	}
 
 	MatchTree *matchtree = new MatchTree(eixrc.getBool("DEFAULT_IS_OR"));
 	parse_cli(matchtree, &eixrc, &varpkg_db, &portagesettings, format, &stability, &header, parse_error, &marked_list, argreader);
 
 	PackageList matches;
+	// The Levenshtein distances of the matches
+	vector<Levenshtein> distances;
+	// A former query of the same process must not enforce sorting
+	FuzzyAlgorithm::reset_sort_by_levenshtein();
 	PackageList all_packages; {
 		PackageReader reader(&db, header, &portagesettings);
+		// If scanned, the reader visits only matches with these distances
+		bool scanned(false);
+		vector<Levenshtein> scanned_distances;
+		if(likely(!rc_options.test_unused)) {
+			// Visit only packages which can match, using the index
+			PackageReader::Pins pins;
+			if(!(matchtree->get_pins(&pins) && reader.restrict_to(pins))) {
+				unsigned int jobs(eixrc.getInteger("PARALLEL_SCAN"));
+				if(jobs == 0) {
+					jobs = count_processors();
+				}
+				scanned = parallel_scan(&reader, &scanned_distances, &db, header, &portagesettings, matchtree, jobs);
+			}
+		}
+		vector<Levenshtein>::size_type scanned_index(0);
 		bool add_rest(false);
 		while(likely(reader.next())) {
+			FuzzyAlgorithm::reset_distance();
 			if(unlikely(add_rest)) {
 				all_packages.PUSH_BACK(reader.release());
-			} else if(unlikely(matchtree->match(&reader))) {
+			} else if(unlikely(scanned || matchtree->match(&reader))) {
 				Package *release(reader.release());
 				if(unlikely(release == NULLPTR)) {
 					break;
 				}
 				matches.PUSH_BACK(release);
+				if(unlikely(scanned)) {
+					// The reader visits exactly the scanned matches
+					if(unlikely(scanned_index == scanned_distances.size())) {
+						eix::say_error(_("internal error: more matches than scanned"));
+						return EXIT_FAILURE;
+					}
+					distances.PUSH_BACK(scanned_distances[scanned_index++]);
+				} else {
+					distances.PUSH_BACK(FuzzyAlgorithm::get_distance());
+				}
 				if(unlikely(only_printed &&
 					(rc_options.brief ||
 						(rc_options.brief2 && (matches.size() > 1))))) {
@@ -944,6 +1115,7 @@ int run_eix(int argc, char** argv) {
 			return EXIT_FAILURE;
 		}
 	}
+	save_stability_cache(stability);
 
 	// Delete old matchtree
 	delete matchtree;
@@ -998,11 +1170,6 @@ int run_eix(int argc, char** argv) {
 		}
 	}
 
-	/* Sort the found matches by rating */
-	if(unlikely(FuzzyAlgorithm::sort_by_levenshtein())) {
-		std::sort(matches.begin(), matches.end(), FuzzyAlgorithm::compare);
-	}
-
 	format->set_marked_list(marked_list);
 	if(overlay_mode != mode_list_used_renumbered) {
 		format->set_overlay_translations(NULLPTR);
@@ -1035,8 +1202,34 @@ int run_eix(int argc, char** argv) {
 	bool reached_limit(false), over_limit(false);
 	string limit_var(rc_options.compact_output ? "EIX_LIMIT_COMPACT" : "EIX_LIMIT");
 	eix::Treesize limit(is_tty ? eixrc.getInteger(limit_var) : 0);
+
+	/* Sort the found matches by rating */
+	vector<eix::UNumber> sort_keys;
+	vector<Package *> unsorted;
+	PackageList::size_type sorted(matches.size());
+	if(unlikely(FuzzyAlgorithm::sort_by_levenshtein())) {
+		unsorted.assign(matches.begin(), matches.end());
+		eix::UNumber size(matches.size());
+		sort_keys.reserve(size);
+		for(PackageList::size_type i(0); likely(i != size); ++i) {
+			sort_keys.PUSH_BACK(distances[i] * size + i);
+		}
+		// Only the matches printed before the limit need to be sorted
+		if((limit != 0) && (limit < size) && (print_formats == NULLPTR) &&
+			(overlay_mode != mode_list_used_renumbered)) {
+			sorted = limit;
+		}
+		sort_matches(&matches, &sort_keys, unsorted, 0, sorted);
+	}
+
 	for(PackageList::iterator it(matches.begin());
 		likely(it != matches.end()); ++it) {
+		// If some matches were not printed, we need more sorted ones
+		if(unlikely(static_cast<PackageList::size_type>(it - matches.begin()) == sorted) &&
+			!reached_limit) {
+			sort_matches(&matches, &sort_keys, unsorted, sorted, matches.size());
+			sorted = matches.size();
+		}
 		stability.set_stability(*it);
 
 		if(unlikely(print_formats != NULLPTR)) {
@@ -1180,6 +1373,440 @@ GCC_DIAG_ON(sign-conversion)
 	return EXIT_SUCCESS;
 }  // NOLINT(readability/fn_size)
 
+/**
+A query of --batch with its matches
+**/
+class BatchQuery {
+	public:
+		string query;
+		MatchTree *matchtree;
+		MaskList<Mask> *marked_list;
+		PackageList matches;
+		vector<Levenshtein> distances;
+		bool sort_by_levenshtein;
+
+		explicit BatchQuery(const string& q, bool default_is_or)
+			: query(q), matchtree(new MatchTree(default_is_or)), marked_list(NULLPTR),
+			sort_by_levenshtein(false) {
+		}
+
+		~BatchQuery() {
+			delete matchtree;
+			delete marked_list;
+		}
+};
+typedef eix::ptr_container<vector<BatchQuery *> > BatchQueries;
+
+/**
+A line of --batch is an eix EXPRESSION (split at spaces) or a single atom.
+The latter is matched like with --pipe
+**/
+ATTRIBUTE_NONNULL_ static void parse_batch(BatchQuery *query, const EixOptionList& options, EixRc *eixrc, VarDbPkg *varpkg_db, PortageSettings *portagesettings, const SetStability *stability, const DBHeader *header);
+static void parse_batch(BatchQuery *query, const EixOptionList& options, EixRc *eixrc, VarDbPkg *varpkg_db, PortageSettings *portagesettings, const SetStability *stability, const DBHeader *header) {
+	WordVec words;
+	split_string(&words, query->query);
+	if((words.size() == 1) && (words[0][0] != '-') &&
+		(words[0].find('/') != string::npos)) {
+		Mask m(Mask::maskMark);
+		string errtext;
+		if(m.parseMask(words[0].c_str(), &errtext, -1) != BasicVersion::parsedError) {
+			query->marked_list = new MaskList<Mask>;
+			query->marked_list->add(m);
+			PackageTest *test(new PackageTest(varpkg_db, portagesettings, format, stability, header, parse_error));
+			*test = PackageTest::CATEGORY_NAME;
+			test->setAlgorithm(PackageTest::ALGO_EXACT);
+			test->setPattern((string(m.getCategory()) + "/" + m.getName()).c_str());
+			test->SetMarkedList(query->marked_list);
+			query->matchtree->parse_test(test, false);
+			query->matchtree->end_parse();
+			return;
+		}
+	}
+	vector<const char *> argv;
+	argv.PUSH_BACK("eix");
+	for(WordVec::const_iterator it(words.begin()); likely(it != words.end()); ++it) {
+		argv.PUSH_BACK(it->c_str());
+	}
+	ArgumentReader argreader(static_cast<int>(argv.size()), &(argv[0]), options);
+	parse_cli(query->matchtree, eixrc, varpkg_db, portagesettings, format, stability, header, parse_error, &(query->marked_list), argreader);
+}
+
+/**
+Evaluate all queries of --batch in a single pass through the database
+and print the matches of each query separately
+**/
+static int run_batch(EixRc *eixrc, Database *db, DBHeader *header, PortageSettings *portagesettings, VarDbPkg *varpkg_db, SetStability *stability) {
+	std::ifstream file;
+	std::istream *in(&std::cin);
+	if(std::strcmp(batch_file, "-") != 0) {
+		file.open(batch_file);
+		if(unlikely(!file.is_open())) {
+			eix::say_error(_("cannot read %s")) % batch_file;
+			return EXIT_FAILURE;
+		}
+		in = &file;
+	}
+	bool default_is_or(eixrc->getBool("DEFAULT_IS_OR"));
+	BatchQueries queries;
+	EixOptionList options;
+	string line;
+	while(std::getline(*in, line)) {
+		trim(&line);
+		if(line.empty() || (line[0] == '#')) {
+			continue;
+		}
+		BatchQuery *query(new BatchQuery(line, default_is_or));
+		queries.PUSH_BACK(query);
+		parse_batch(query, options, eixrc, varpkg_db, portagesettings, stability, header);
+	}
+
+	// Visit only packages which can match some query
+	PackageList all_packages; {
+		PackageReader reader(db, *header, portagesettings);
+		PackageReader::Pins pins;
+		bool restricted(true);
+		for(BatchQueries::iterator it(queries.begin());
+			likely(it != queries.end()); ++it) {
+			PackageReader::Pins query_pins;
+			if(!it->matchtree->get_pins(&query_pins)) {
+				restricted = false;
+				break;
+			}
+			pins.insert(pins.end(), query_pins.begin(), query_pins.end());
+		}
+		if(restricted) {
+			reader.restrict_to(pins);
+		}
+		vector<BatchQuery *> matched;
+		while(likely(reader.next())) {
+			matched.clear();
+			vector<Levenshtein> distances;
+			for(BatchQueries::iterator it(queries.begin());
+				likely(it != queries.end()); ++it) {
+				FuzzyAlgorithm::reset_distance();
+				FuzzyAlgorithm::reset_sort_by_levenshtein();
+				if(it->matchtree->match(&reader)) {
+					matched.PUSH_BACK(*it);
+					distances.PUSH_BACK(FuzzyAlgorithm::get_distance());
+				}
+				if(unlikely(FuzzyAlgorithm::sort_by_levenshtein())) {
+					it->sort_by_levenshtein = true;
+				}
+			}
+			if(matched.empty()) {
+				if(unlikely(!reader.skip())) {
+					break;
+				}
+				continue;
+			}
+			Package *release(reader.release());
+			if(unlikely(release == NULLPTR)) {
+				break;
+			}
+			all_packages.PUSH_BACK(release);
+			for(vector<BatchQuery *>::size_type i(0); likely(i != matched.size()); ++i) {
+				matched[i]->matches.PUSH_BACK(release);
+				matched[i]->distances.PUSH_BACK(distances[i]);
+			}
+		}
+		const char *err_cstr(reader.get_errtext());
+		if(unlikely(err_cstr != NULLPTR)) {
+			eix::say_error() % err_cstr;
+			return EXIT_FAILURE;
+		}
+	}
+	save_stability_cache(*stability);
+
+	PrintFormats *print_formats(NULLPTR);
+	if(rc_options.xml) {
+		if(unlikely(rc_options.proto)) {
+			eix::say_error(_("--xml and --proto must not be specified simultaneously"));
+			std::exit(EXIT_FAILURE);
+		}
+		print_formats = new PrintXml(header, varpkg_db, format, stability, eixrc,
+			(*portagesettings)["PORTDIR"]);
+	} else if(rc_options.proto) {
+		print_formats = new PrintProto(header, varpkg_db, format, stability);
+	}
+	if(print_formats != NULLPTR) {
+		overlay_mode = mode_list_none;
+		rc_options.pure_packages = true;
+		print_formats->start();
+	} else if(overlay_mode == mode_list_used_renumbered) {
+		overlay_mode = mode_list_used;
+	}
+	format->set_overlay_translations(NULLPTR);
+	bool need_overlay_table(false);
+	PrintFormat::OverlayUsed overlay_used(header->countOverlays(), false);
+	format->set_overlay_used(&overlay_used, &need_overlay_table);
+	eix::SignedBool print_count_always(rc_options.pure_packages ? -1 :
+		eixrc->getBoolText("PRINT_COUNT_ALWAYS", "never"));
+	bool found(false);
+	for(BatchQueries::iterator it(queries.begin());
+		likely(it != queries.end()); ++it) {
+		PackageList& matches(it->matches);
+		if(unlikely(it->sort_by_levenshtein)) {
+			vector<Package *> unsorted(matches.begin(), matches.end());
+			eix::UNumber size(matches.size());
+			vector<eix::UNumber> sort_keys;
+			sort_keys.reserve(size);
+			for(PackageList::size_type i(0); likely(i != size); ++i) {
+				sort_keys.PUSH_BACK(it->distances[i] * size + i);
+			}
+			sort_matches(&matches, &sort_keys, unsorted, 0, size);
+		}
+		if(!matches.empty()) {
+			found = true;
+		}
+		if(print_formats != NULLPTR) {
+			print_formats->query(it->query);
+			for(PackageList::iterator m(matches.begin());
+				likely(m != matches.end()); ++m) {
+				stability->set_stability(*m);
+				print_formats->package(*m);
+			}
+			continue;
+		}
+		eix::say("%s-- %s%s")
+			% format->color_numbertext
+			% it->query
+			% format->color_numbertextend;
+		format->set_marked_list(it->marked_list);
+		PackageList::size_type count(0);
+		for(PackageList::iterator m(matches.begin());
+			likely(m != matches.end()); ++m) {
+			stability->set_stability(*m);
+			if(m->largest_overlay != 0) {
+				need_overlay_table = true;
+				if(overlay_mode <= mode_list_used) {
+					for(Package::iterator ver(m->begin());
+						likely(ver != m->end()); ++ver) {
+						ExtendedVersion::Overlay key(ver->overlay_key);
+						if(key > 0) {
+							overlay_used[key - 1] = true;
+						}
+					}
+				}
+			}
+			if(format->print(*m, header, varpkg_db, portagesettings, stability, false)) {
+				++count;
+			}
+		}
+		if(likely(print_count_always >= 0)) {
+			if((print_count_always != 0) || (count > 1)) {
+				eix::say("%s%s%s")
+					% format->color_numbertext
+					% (eix::format(N_("Found %s match",
+						"Found %s matches", count))
+						% count)
+					% format->color_numbertextend;
+			} else if(unlikely(count == 0)) {
+				eix::say("%s%s%s")
+					% format->color_numbertext
+					% _("No matches found")
+					% format->color_numbertextend;
+			}
+		}
+	}
+	format->set_marked_list(NULLPTR);
+	if(print_formats != NULLPTR) {
+		print_formats->finish();
+		delete print_formats;
+	} else {
+		if(overlay_mode == mode_list_all) {
+			need_overlay_table = true;
+		} else if(overlay_mode == mode_list_none) {
+			need_overlay_table = false;
+		}
+		if(need_overlay_table) {
+			print_overlay_table(format, header,
+				(overlay_mode <= mode_list_used) ? &overlay_used : NULLPTR);
+		}
+		eix::print() % format->color_end;
+	}
+	queries.delete_and_clear();
+	all_packages.delete_and_clear();
+	if(unlikely(!found)) {
+GCC_DIAG_OFF(sign-conversion)
+		return eixrc->getInteger("NOFOUND_STATUS");
+GCC_DIAG_ON(sign-conversion)
+	}
+	return EXIT_SUCCESS;
+}
+
+/**
+Collect the stamps of all files whose change makes the resident data stale
+**/
+ATTRIBUTE_NONNULL_ static void get_server_stamps(FileStamps *stamps, EixRc *eixrc, const Resident& resident) {
+	stamps->clear();
+	stamps->add(resident.cachefile, 0);
+	stamps->add_tree(eixrc->m_eprefixconf + "/etc/portage", false);
+	stamps->add((*eixrc)["EPREFIX_INSTALLED"] + VAR_DB_PKG, 1);
+	stamps->add((*eixrc)["EIX_WORLD"], 0);
+	stamps->add((*eixrc)["EIX_WORLD_SETS"], 0);
+}
+
+/**
+Collect everything on which the flags in the STABILITY_CACHEFILE depend
+**/
+ATTRIBUTE_NONNULL_ static void get_stability_key(string *key, EixRc *eixrc, const PortageSettings& portagesettings, const string& cachefile) {
+	FileStamps stamps;
+	stamps.add(cachefile, 0);
+	stamps.add_tree(eixrc->m_eprefixconf + "/etc/portage", true);
+	for(WordVec::const_iterator it(portagesettings.read_files.begin());
+		likely(it != portagesettings.read_files.end()); ++it) {
+		stamps.add_tree(*it, true);
+	}
+	key->assign(PACKAGE_VERSION "\n");
+	stamps.append_to(key);
+	static const char *const vars[] = {
+		"ALWAYS_ACCEPT_KEYWORDS",
+		"ACCEPT_KEYWORDS_AS_ARCH",
+		"RECURSIVE_SETS",
+		NULLPTR
+	};
+	for(const char *const *var(vars); likely(*var != NULLPTR); ++var) {
+		key->append(eix::format("%s=%s\n") % *var % (*eixrc)[*var]);
+	}
+	// The variables of make.conf, the profile, and the environment
+	for(WordIterateMap::const_iterator it(portagesettings.begin());
+		likely(it != portagesettings.end()); ++it) {
+		key->append(eix::format("%s=%s\n") % it->first % it->second);
+	}
+}
+
+/**
+Write the STABILITY_CACHEFILE if the scan added something
+**/
+static void save_stability_cache(const SetStability& stability) {
+	string errtext;
+	if(unlikely(!stability.save_cache(&errtext))) {
+		eix::say_error() % errtext;
+	}
+}
+
+/**
+Answer the query of the client connected at fd in a subprocess.
+The query uses the resident data unless this is NULLPTR.
+**/
+ATTRIBUTE_NORETURN ATTRIBUTE_NONNULL((2, 4)) static void serve_query(int fd, EixRc *eixrc, Resident *resident, const char *program) {
+	in_server = true;
+	string dir, errtext;
+	WordVec args;
+	if(unlikely(!server_receive(fd, &dir, &args, &errtext))) {
+		eix::say_error() % errtext;
+		_exit(EXIT_FAILURE);
+	}
+	int status(EXIT_FAILURE);
+	// The query runs in a further subprocess, so that we can report its
+	// exit status even if it calls exit() somewhere
+	pid_t child(fork());
+	if(child == 0) {
+		close(fd);
+		if(unlikely(chdir(dir.c_str()) != 0)) {
+			eix::say_error(_("cannot change to directory %s")) % dir;
+		}
+		// Several queries must not share the position of an unmapped file
+		if((resident != NULLPTR) && !resident->db.is_mapped()) {
+			resident->db.destroy();
+			if(unlikely(!resident->db.openread(resident->cachefile.c_str()) ||
+				!resident->db.seekabs(resident->db_offset, &errtext))) {
+				eix::say_error(_("cannot reopen %s")) % resident->cachefile;
+				std::exit(EXIT_FAILURE);
+			}
+		}
+		vector<char *> argv;
+		argv.PUSH_BACK(const_cast<char *>(program));
+		for(WordVec::iterator it(args.begin()); likely(it != args.end()); ++it) {
+			argv.PUSH_BACK(const_cast<char *>(it->c_str()));
+		}
+		int argc(static_cast<int>(argv.size()));
+		argv.PUSH_BACK(NULLPTR);
+		std::exit(run_eix_query(eixrc, argc, &(argv[0]), resident));
+	}
+	if(likely(child > 0)) {
+		int wstatus;
+		pid_t r;
+		while(((r = waitpid(child, &wstatus, 0)) == -1) && (errno == EINTR)) {
+		}
+GCC_DIAG_OFF(old-style-cast)
+		if(likely(r == child)) {
+			if(likely(WIFEXITED(wstatus))) {
+				status = WEXITSTATUS(wstatus);
+			} else if(WIFSIGNALED(wstatus)) {
+				status = 128 + WTERMSIG(wstatus);
+			}
+		}
+GCC_DIAG_ON(old-style-cast)
+	}
+	server_reply(fd, status);
+	_exit(EXIT_SUCCESS);
+}
+
+/**
+Answer queries at the socket server_socket until the resident data is stale
+@return RELOAD_SERVER or the exit status in case of an error
+**/
+static int run_server(EixRc *eixrc, Resident *resident, const char *program) {
+	if(server_fd < 0) {
+		string errtext;
+		server_fd = server_listen(server_socket, &errtext);
+		if(unlikely(server_fd < 0)) {
+			eix::say_error() % errtext;
+			return EXIT_FAILURE;
+		}
+	}
+	resident->varpkg_db->readAllCategories();
+	FileStamps stamps;
+	get_server_stamps(&stamps, eixrc, *resident);
+	std::fflush(stdout);
+	std::fflush(stderr);
+	// The queries are not waited for
+	std::signal(SIGCHLD, SIG_IGN);
+	for(;;) {
+		int fd(server_accept(server_fd));
+		if(unlikely(fd < 0)) {
+			eix::say_error(_("cannot accept connections on socket %s")) % server_socket;
+			return EXIT_FAILURE;
+		}
+		FileStamps current;
+		get_server_stamps(&current, eixrc, *resident);
+		bool stale(current != stamps);
+		pid_t child(fork());
+		if(child == 0) {
+			close(server_fd);
+			std::signal(SIGCHLD, SIG_DFL);
+			serve_query(fd, eixrc, (stale ? NULLPTR : resident), program);
+		}
+		close(fd);
+		if(unlikely(child < 0)) {
+			eix::say_error(_("cannot fork for a query"));
+		}
+		if(unlikely(stale)) {
+			// The stale query was answered from scratch; now read the data anew
+			std::signal(SIGCHLD, SIG_DFL);
+			return RELOAD_SERVER;
+		}
+	}
+}
+
+/**
+eix --client SOCKET ARGS: Let the server at SOCKET answer the query ARGS
+**/
+static int run_eix_client(int argc, char **argv) {
+	if(unlikely(argc < 3)) {
+		eix::say_error(_("--client needs the socket of the server as argument"));
+		return EXIT_FAILURE;
+	}
+	int status;
+	string errtext;
+	if(unlikely(!run_client(argv[2], argc - 3, argv + 3, &status, &errtext))) {
+		eix::say_error() % errtext;
+		return EXIT_FAILURE;
+	}
+	return status;
+}
+
 static bool opencache(Database *db, const char *filename, const char *tooltext) {
 	if(likely(db->openread(filename))) {
 		return true;
@@ -1208,6 +1835,24 @@ static void print_wordvec(const WordVec& vec) {
 	eix::say("--");
 }
 
+/**
+Sort the keys (distance * size + position) of matches in the range
+[begin, end) to the front of [begin, keys->size()) and reorder matches
+accordingly; equal distances keep the order of the database.
+If end is not the size, the others are in unspecified order.
+**/
+static void sort_matches(PackageList *matches, vector<eix::UNumber> *keys, const vector<Package *>& unsorted, PackageList::size_type begin, PackageList::size_type end) {
+	if(end == keys->size()) {
+		std::sort(keys->begin() + begin, keys->end());
+	} else {
+		std::partial_sort(keys->begin() + begin, keys->begin() + end, keys->end());
+	}
+	eix::UNumber size(keys->size());
+	for(PackageList::size_type i(begin); likely(i != size); ++i) {
+		(*matches)[i] = unsorted[(*keys)[i] % size];
+	}
+}
+
 static void print_unused(const string& filename, const string& excludefiles, const PackageList& packagelist, bool test_empty) {
 	WordVec unused;
 	LineVec lines;
@@ -0,0 +1,98 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#include "eixTk/globindex.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <fnmatch.h>
+
+#include <algorithm>
+#include <string>
+
+#include "eixTk/dialect.h"
+#include "eixTk/likely.h"
+
+using std::string;
+
+void GlobIndex::clear() {
+	patterns.clear();
+	prefixes.clear();
+	suffixes.clear();
+	prefix_lengths.clear();
+	suffix_lengths.clear();
+	others.clear();
+}
+
+void GlobIndex::add_length(Lengths *lengths, Length len) {
+	Lengths::iterator it(std::lower_bound(lengths->begin(), lengths->end(), len));
+	if((it == lengths->end()) || (*it != len)) {
+		lengths->insert(it, len);
+	}
+}
+
+void GlobIndex::add(const string& pattern) {
+	Index index(patterns.size());
+	patterns.PUSH_BACK(pattern);
+	// Backslash is an escape character for fnmatch: stop there, too
+	Length prefix(pattern.find_first_of("*?[\\"));
+	if(prefix == string::npos) {
+		prefix = pattern.size();
+	}
+	Length suffix(pattern.find_last_of("*?[]\\"));
+	suffix = ((suffix == string::npos) ? pattern.size() : (pattern.size() - suffix - 1));
+	if((prefix == 0) && (suffix == 0)) {
+		others.PUSH_BACK(index);
+		return;
+	}
+	if(prefix >= suffix) {
+		prefixes[pattern.substr(0, prefix)].PUSH_BACK(index);
+		add_length(&prefix_lengths, prefix);
+		return;
+	}
+	suffixes[pattern.substr(pattern.size() - suffix)].PUSH_BACK(index);
+	add_length(&suffix_lengths, suffix);
+}
+
+void GlobIndex::push_match(Indices *result, const string& name, const Indices& candidates) const {
+	for(Indices::const_iterator it(candidates.begin());
+		likely(it != candidates.end()); ++it) {
+		if(fnmatch(patterns[*it].c_str(), name.c_str(), FNM_PATHNAME) == 0) {
+			result->PUSH_BACK(*it);
+		}
+	}
+}
+
+void GlobIndex::find_literal(Indices *result, const string& name, const Literals& literals, const Lengths& lengths, bool prefix) const {
+	string key;
+	for(Lengths::const_iterator it(lengths.begin());
+		likely((it != lengths.end()) && (*it <= name.size())); ++it) {
+		if(prefix) {
+			key.assign(name, 0, *it);
+		} else {
+			key.assign(name, name.size() - *it, *it);
+		}
+		Literals::const_iterator found(literals.find(key));
+		if(found != literals.end()) {
+			push_match(result, name, found->second);
+		}
+	}
+}
+
+void GlobIndex::find(Indices *result, const string& name) const {
+	result->clear();
+	find_literal(result, name, prefixes, prefix_lengths, true);
+	find_literal(result, name, suffixes, suffix_lengths, false);
+	push_match(result, name, others);
+	// Each pattern is filed only once, so there are no duplicates
+	std::sort(result->begin(), result->end());
+}
+
+bool GlobIndex::match(const string& name) const {
+	Indices result;
+	find(&result, name);
+	return !result.empty();
+}
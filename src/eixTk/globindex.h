@@ -0,0 +1,84 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#ifndef SRC_EIXTK_GLOBINDEX_H_
+#define SRC_EIXTK_GLOBINDEX_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/unordered_map.h"
+
+/**
+An index of fnmatch(FNM_PATHNAME) patterns which are numbered in the order
+in which they were added. Each pattern is filed under its longest literal
+prefix or suffix, so that a lookup needs to call fnmatch only for the few
+patterns whose literal part fits the name.
+**/
+class GlobIndex {
+	public:
+		typedef WordVec::size_type Index;
+		typedef std::vector<Index> Indices;
+
+	private:
+		typedef std::string::size_type Length;
+		typedef std::vector<Length> Lengths;
+		typedef UNORDERED_MAP<std::string, Indices> Literals;
+
+		WordVec patterns;
+		Literals prefixes, suffixes;
+		/**
+		The distinct lengths of the keys in prefixes and suffixes, sorted
+		**/
+		Lengths prefix_lengths, suffix_lengths;
+		/**
+		The patterns without any literal prefix or suffix
+		**/
+		Indices others;
+
+		ATTRIBUTE_NONNULL_ static void add_length(Lengths *lengths, Length len);
+
+		ATTRIBUTE_NONNULL_ void find_literal(Indices *result, const std::string& name, const Literals& literals, const Lengths& lengths, bool prefix) const;
+
+		ATTRIBUTE_NONNULL_ void push_match(Indices *result, const std::string& name, const Indices& candidates) const;
+
+	public:
+		bool empty() const {
+			return patterns.empty();
+		}
+
+		Index size() const {
+			return patterns.size();
+		}
+
+		const std::string& pattern(Index i) const {
+			return patterns[i];
+		}
+
+		void clear();
+
+		/**
+		Add the pattern with the index size()
+		**/
+		void add(const std::string& pattern);
+
+		/**
+		Store the ascending indices of all patterns matching name
+		**/
+		ATTRIBUTE_NONNULL_ void find(Indices *result, const std::string& name) const;
+
+		/**
+		@return true if some pattern matches name
+		**/
+		bool match(const std::string& name) const;
+};
+
+#endif  // SRC_EIXTK_GLOBINDEX_H_
@@ -10,7 +10,12 @@
 #include "eixTk/regexp.h"
 #include <config.h>  // IWYU pragma: keep
 
+#ifdef WITH_RE2
+#include <re2/re2.h>
+#endif
+
 #include <cstdlib>
+#include <cstring>
 
 #include <string>
 #include <vector>
@@ -31,22 +36,83 @@ Free the regular expression
 **/
 void Regex::clear() {
 	if(m_compiled) {
+#ifdef WITH_RE2
+		if(m_re2 != NULLPTR) {
+			delete m_re2;
+			m_re2 = NULLPTR;
+		} else
+#endif
 		regfree(&m_re);
 		m_compiled = false;
 	}
+	m_literal.clear();
+}
+
+#ifdef WITH_RE2
+/**
+@return true if regex has a backslash in a bracket expression:
+regcomp() takes it literally, but re2 does not
+**/
+static bool backslash_in_brackets(const char *regex) {
+	for(const char *p(std::strchr(regex, '[')); p != NULLPTR; p = std::strchr(p, '[')) {
+		++p;
+		if(*p == '^') {
+			++p;
+		}
+		if(*p == ']') {
+			++p;
+		}
+		for(; (*p != '\0') && (*p != ']'); ++p) {
+			if(*p == '\\') {
+				return true;
+			}
+			// Skip [:class:], [=equiv=], and [.coll.]
+			if((*p == '[') && ((p[1] == ':') || (p[1] == '=') || (p[1] == '.'))) {
+				const char end[3] = { p[1], ']', '\0' };
+				const char *q(std::strstr(p + 2, end));
+				if(q != NULLPTR) {
+					p = q + 1;
+				}
+			}
+		}
+	}
+	return false;
 }
+#endif
 
 /**
 Compile a regular expression
 **/
 void Regex::compile(const char *regex, int eflags) {
-	if(unlikely(m_compiled)) {
-		regfree(&m_re);
-		m_compiled = false;
-	}
+	clear();
 	if((regex == NULLPTR) || (regex[0] == '\0')) {
 		return;
 	}
+	set_literal(regex, ((eflags & REG_ICASE) != 0));
+
+#ifdef WITH_RE2
+	// Use re2 only with the syntax and semantics of POSIX
+	if(!backslash_in_brackets(regex)) {
+		RE2::Options options;
+		options.set_posix_syntax(true);
+		options.set_longest_match(true);
+		options.set_log_errors(false);
+		options.set_case_sensitive((eflags & REG_ICASE) == 0);
+		options.set_one_line((eflags & REG_NEWLINE) == 0);
+		options.set_dot_nl((eflags & REG_NEWLINE) == 0);
+		if(MB_CUR_MAX == 1) {
+			options.set_encoding(RE2::Options::EncodingLatin1);
+		}
+		m_re2 = new RE2(regex, options);
+		if(likely(m_re2->ok())) {
+			m_compiled = true;
+			return;
+		}
+		// Let regcomp() decide about expressions unknown to re2
+		delete m_re2;
+		m_re2 = NULLPTR;
+	}
+#endif
 
 	int retval(regcomp(&m_re, regex, eflags|REG_EXTENDED));
 	if(unlikely(retval != 0)) {
@@ -63,7 +129,26 @@ void Regex::compile(const char *regex, int eflags) {
 @return true if the regular expression matches
 **/
 bool Regex::match(const char *s) const {
-	return (!m_compiled) || (!regexec(get(), s, 0, NULLPTR, 0));
+	if(!m_compiled) {
+		return true;
+	}
+	int found(find_literal(s));
+	if(found >= 0) {
+		return ((found != 0) && (m_literal_only || match_expression(s)));
+	}
+	return match_expression(s);
+}
+
+/**
+Match without looking at m_literal
+**/
+bool Regex::match_expression(const char *s) const {
+#ifdef WITH_RE2
+	if(m_re2 != NULLPTR) {
+		return RE2::PartialMatch(s, *m_re2);
+	}
+#endif
+	return !regexec(get(), s, 0, NULLPTR, 0);
 }
 
 /**
@@ -73,7 +158,6 @@ bool Regex::match(const char *s) const {
 @return true if the regular expression matches
 **/
 bool Regex::match(const char *s, string::size_type *b, string::size_type *e) const {
-	regmatch_t pmatch[1];
 	if(!m_compiled) {
 		if(likely(b != NULLPTR)) {
 			*b = 0;
@@ -83,24 +167,160 @@ bool Regex::match(const char *s, string::size_type *b, string::size_type *e) con
 		}
 		return true;
 	}
-	if(regexec(get(), s, 1, pmatch, 0)) {
-		if(likely(b != NULLPTR)) {
-			*b = string::npos;
-		}
-		if(likely(e != NULLPTR)) {
-			*e = string::npos;
+	string::size_type begin(string::npos), end(string::npos);
+	if(find_literal(s) != 0) {
+#ifdef WITH_RE2
+		if(m_re2 != NULLPTR) {
+			re2::StringPiece text(s), found;
+			if(m_re2->Match(text, 0, text.size(), RE2::UNANCHORED, &found, 1)) {
+				begin = static_cast<string::size_type>(found.data() - s);
+				end = begin + found.size();
+			}
+		} else
+#endif
+		{
+			regmatch_t pmatch[1];
+			if(!regexec(get(), s, 1, pmatch, 0)) {
+GCC_DIAG_OFF(sign-conversion)
+				begin = pmatch[0].rm_so;
+				end = pmatch[0].rm_eo;
+GCC_DIAG_ON(sign-conversion)
+			}
 		}
-		return false;
 	}
 	if(likely(b != NULLPTR)) {
-GCC_DIAG_OFF(sign-conversion)
-		*b = pmatch[0].rm_so;
-GCC_DIAG_ON(sign-conversion)
+		*b = begin;
 	}
 	if(likely(e != NULLPTR)) {
-GCC_DIAG_OFF(sign-conversion)
-		*e = pmatch[0].rm_eo;
-GCC_DIAG_ON(sign-conversion)
+		*e = end;
+	}
+	return (begin != string::npos);
+}
+
+int Regex::find_literal(const char *s) const {
+	if(m_literal.empty()) {
+		return -1;
+	}
+	if(m_icase) {
+		return casecontains_ascii(s, m_literal.c_str(), m_literal.size());
+	}
+	return ((find_substring(s, m_literal.c_str(), m_literal.size()) != NULLPTR) ? 1 : 0);
+}
+
+void Regex::set_literal(const char *regex, bool icase) {
+	m_icase = icase;
+	m_literal_only = false;
+	WordVec literals;
+	if(!get_literals(&literals, regex)) {
+		return;
+	}
+	for(WordVec::iterator it(literals.begin()); likely(it != literals.end()); ++it) {
+		if(!icase) {
+			if(it->size() > m_literal.size()) {
+				m_literal = *it;
+			}
+			continue;
+		}
+		// Only ASCII characters are compared case-insensitively
+		string::size_type start(0);
+		for(string::size_type i(0); ; ++i) {
+			if((i != it->size()) && (((*it)[i] & 0x80) == 0)) {
+				continue;
+			}
+			if(i - start > m_literal.size()) {
+				m_literal = to_lower(it->substr(start, i - start));
+			}
+			if(i == it->size()) {
+				break;
+			}
+			start = i + 1;
+		}
+	}
+	// Is the whole expression just the literal?
+	m_literal_only = ((m_literal.size() == std::strlen(regex)) &&
+		(std::strpbrk(regex, "\\^$.[]|()*+?{}") == NULLPTR));
+}
+
+bool Regex::get_literals(WordVec *literals, const string& regex) {
+	if(regex.find('|') != string::npos) {
+		return false;
+	}
+	string curr;
+	unsigned int depth(0);
+	for(string::size_type i(0); likely(i < regex.size()); ++i) {
+		char c(regex[i]);
+		switch(c) {
+			case '?':
+			case '*':
+			case '{':
+				// The preceding character is optional; remove all its bytes
+				while(!curr.empty()) {
+					char last(curr[curr.size() - 1]);
+					curr.erase(curr.size() - 1);
+					if(isutf8firstbyte(last)) {
+						break;
+					}
+				}
+				if(c == '{') {
+					i = regex.find('}', i);
+					if(i == string::npos) {
+						i = regex.size() - 1;
+					}
+				}
+				break;
+			case '[':
+				// Skip the bracket expression; ] is literal at its beginning
+				if((++i < regex.size()) && (regex[i] == '^')) {
+					++i;
+				}
+				if((i < regex.size()) && (regex[i] == ']')) {
+					++i;
+				}
+				for(; likely(i < regex.size()) && (regex[i] != ']'); ++i) {
+					// Skip [:class:], [=equiv=], and [.coll.]
+					char d;
+					if((regex[i] == '[') && (i + 1 < regex.size()) &&
+						(((d = regex[i + 1]) == ':') || (d == '=') || (d == '.'))) {
+						string::size_type end(regex.find(string(1, d) + "]", i + 2));
+						if(end != string::npos) {
+							i = end + 1;
+						}
+					}
+				}
+				if(i >= regex.size()) {
+					i = regex.size() - 1;
+				}
+				break;
+			case '(':
+				++depth;
+				break;
+			case ')':
+				if(depth != 0) {
+					--depth;
+				}
+				break;
+			case '\\':
+				++i;
+				break;
+			case '+':
+			case '.':
+			case '^':
+			case '$':
+				break;
+			default:
+				if(depth == 0) {
+					curr.append(1, c);
+					continue;
+				}
+				break;
+		}
+		if(!curr.empty()) {
+			literals->PUSH_BACK(curr);
+			curr.clear();
+		}
+	}
+	if(!curr.empty()) {
+		literals->PUSH_BACK(curr);
 	}
 	return true;
 }
@@ -19,11 +19,24 @@
 
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
+#include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
+
+#ifdef WITH_RE2
+namespace re2 {
+class RE2;
+}  // namespace re2
+#endif
 
 /**
 Handle regular expressions.
 It is normally used within global scope so that a regular expression doesn't
 have to be compiled with every instance of a class using it.
+If eix is compiled with re2, that library is used for all expressions
+which it understands in the same way as regcomp().
+Before any match, it is checked whether the string contains a literal which
+every match must contain; if the expression is just that literal, no more
+is needed.
 **/
 
 class Regex {
@@ -39,12 +52,14 @@ class Regex {
 		Initalize class
 		**/
 		Regex() : m_compiled(false) {
+			init();
 		}
 
 		/**
 		Initalize and compile regular expression
 		**/
 		Regex(const char *regex, int eflags) : m_compiled(false) {
+			init();
 			compile(regex, eflags);
 		}
 
@@ -52,6 +67,7 @@ class Regex {
 		Initalize and compile regular expression
 		**/
 		explicit Regex(const char *regex) : m_compiled(false) {
+			init();
 			compile(regex, REG_EXTENDED);
 		}
 
@@ -90,6 +106,13 @@ class Regex {
 			return m_compiled;
 		}
 
+		/**
+		Split the extended regular expression regex into literal strings
+		which every match must contain.
+		@return false if this is not possible
+		**/
+		ATTRIBUTE_NONNULL_ static bool get_literals(WordVec *literals, const std::string& regex);
+
 	protected:
 		/**
 		Get the internal regular expression structure
@@ -107,6 +130,47 @@ class Regex {
 		Is the regex already compiled and nonempty?
 		**/
 		bool m_compiled;
+
+		/**
+		A literal which every match contains (or empty).
+		For case insensitive matching, it is in lowercase.
+		**/
+		std::string m_literal;
+		bool m_icase;
+
+		/**
+		Is the expression just m_literal?
+		**/
+		bool m_literal_only;
+
+#ifdef WITH_RE2
+		/**
+		The expression compiled by re2 or NULLPTR if regcomp() is used
+		**/
+		re2::RE2 *m_re2;
+
+		void init() {
+			m_re2 = NULLPTR;
+		}
+#else
+		void init() {
+		}
+#endif
+
+		/**
+		@return 1 if s contains m_literal, 0 if not, and -1 if this is unknown
+		**/
+		ATTRIBUTE_NONNULL_ int find_literal(const char *s) const;
+
+		/**
+		Match without looking at m_literal
+		**/
+		ATTRIBUTE_NONNULL_ bool match_expression(const char *s) const;
+
+		/**
+		Set m_literal for the expression regex
+		**/
+		ATTRIBUTE_NONNULL_ void set_literal(const char *regex, bool icase);
 };
 
 class RegexList {
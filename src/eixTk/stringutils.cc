@@ -794,6 +794,116 @@ bool casecontains(const char *str, const char *pattern) {
 	return false;
 }
 
+/**
+Lowercase an ASCII letter; other characters are unchanged
+**/
+ATTRIBUTE_CONST inline static char ascii_tolower(char c) {
+	return (((c >= 'A') && (c <= 'Z')) ? static_cast<char>(c + ('a' - 'A')) : c);
+}
+
+/**
+Compare len characters, ignoring the case of ASCII letters in s if ICASE
+**/
+template<bool ICASE> ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE inline static bool equal_chars(const char *s, const char *pattern, string::size_type len) {
+	if(!ICASE) {
+		return (std::memcmp(s, pattern, len) == 0);
+	}
+	for(; len != 0; --len) {
+		if(ascii_tolower(*(s++)) != *(pattern++)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+#ifdef SUPPORT_SSE2
+/**
+Load 16 characters from the unaligned address p
+**/
+inline static __m128i load16(const char *p) {
+GCC_DIAG_OFF(cast-align)
+	return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+GCC_DIAG_ON(cast-align)
+}
+
+/**
+Lowercase the ASCII letters of 16 characters
+**/
+inline static __m128i ascii_tolower16(__m128i c) {
+	__m128i upper(_mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('A' - 1)),
+		_mm_cmplt_epi8(c, _mm_set1_epi8('Z' + 1))));
+	return _mm_or_si128(c, _mm_and_si128(upper, _mm_set1_epi8('a' - 'A')));
+}
+#endif
+
+/**
+Find the nonempty pattern of length len in str of length n.
+The case of ASCII letters in str is ignored if ICASE.
+With sse2, 16 positions at once are checked for the first and
+last character of pattern before the candidates are compared.
+**/
+template<bool ICASE> ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE static const char *find_chars(const char *str, string::size_type n, const char *pattern, string::size_type len) {
+	string::size_type i(0);
+#ifdef SUPPORT_SSE2
+	const __m128i first(_mm_set1_epi8(pattern[0]));
+	const __m128i last(_mm_set1_epi8(pattern[len - 1]));
+	for(; i + len + 15 <= n; i += 16) {
+		__m128i a(load16(str + i));
+		__m128i b(load16(str + i + len - 1));
+		if(ICASE) {
+			a = ascii_tolower16(a);
+			b = ascii_tolower16(b);
+		}
+		unsigned int mask(static_cast<unsigned int>(_mm_movemask_epi8(
+			_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)))));
+		for(; mask != 0; mask &= mask - 1) {
+			const char *candidate(str + i + static_cast<unsigned int>(__builtin_ctz(mask)));
+			if(equal_chars<ICASE>(candidate + 1, pattern + 1, len - 1)) {
+				return candidate;
+			}
+		}
+	}
+#endif
+	for(; i + len <= n; ++i) {
+		if(equal_chars<ICASE>(str + i, pattern, len)) {
+			return str + i;
+		}
+	}
+	return NULLPTR;
+}
+
+/**
+Check whether str of length n contains a non-ASCII character
+**/
+ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE static bool has_nonascii(const char *str, string::size_type n) {
+	string::size_type i(0);
+#ifdef SUPPORT_SSE2
+	for(; i + 16 <= n; i += 16) {
+		if(_mm_movemask_epi8(load16(str + i)) != 0) {
+			return true;
+		}
+	}
+#endif
+	for(; i != n; ++i) {
+		if((str[i] & 0x80) != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+const char *find_substring(const char *str, const char *pattern, string::size_type len) {
+	return find_chars<false>(str, std::strlen(str), pattern, len);
+}
+
+int casecontains_ascii(const char *str, const char *pattern, string::size_type len) {
+	string::size_type n(std::strlen(str));
+	if(find_chars<true>(str, n, pattern, len) != NULLPTR) {
+		return 1;
+	}
+	return (has_nonascii(str, n) ? -1 : 0);
+}
+
 string::size_type utf8size(const string &t, string::size_type begin, string::size_type end) {
 	if(end == string::npos) {
 		end = t.size();
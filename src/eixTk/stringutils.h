@@ -420,6 +420,20 @@ inline static bool casecontains(const std::string& str, const char *pattern) {
 	return casecontains(str.c_str(), pattern);
 }
 
+/**
+Find the nonempty pattern of length len in str
+@return the first occurrence or NULLPTR
+**/
+ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE const char *find_substring(const char *str, const char *pattern, std::string::size_type len);
+
+/**
+Check whether str contains the nonempty lowercase ASCII pattern of length len
+when ASCII letters are compared case-insensitively.
+@return 1 if it does, 0 if it does not, and -1 if it does not but str contains
+non-ASCII characters (which in some locales might also match case-insensitively)
+**/
+ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE int casecontains_ascii(const char *str, const char *pattern, std::string::size_type len);
+
 /**
 Check whether char is utf8 first-byte
 **/
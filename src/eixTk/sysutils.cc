@@ -10,6 +10,7 @@
 #include "eixTk/sysutils.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <fcntl.h>
 #include <grp.h>
 #include <pwd.h>
 // unistd.h is needed on Solaris for including stropts.h, see below
@@ -18,6 +19,10 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#ifdef HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
+
 #ifdef HAVE_TERMIOS_H
 #include <termios.h>
 #endif
@@ -48,6 +53,7 @@
 
 #include "eixTk/diagnostics.h"
 #include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 
@@ -163,3 +169,47 @@ bool get_geometry(unsigned int * /* lines */, unsigned int * /* columns */) {
 	return false;
 }
 #endif
+
+unsigned int count_processors() {
+#ifdef _SC_NPROCESSORS_ONLN
+	long n(sysconf(_SC_NPROCESSORS_ONLN));
+	if(likely(n > 0)) {
+		return static_cast<unsigned int>(n);
+	}
+#endif
+	return 1;
+}
+
+#ifdef HAVE_POSIX_FADVISE
+void prefetch_file(const char *file) {
+	int fd(open(file, O_RDONLY));
+	if(likely(fd >= 0)) {
+		posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+		close(fd);
+	}
+}
+#else
+void prefetch_file(const char * /* file */) {
+}
+#endif
+
+#ifdef HAVE_GETRUSAGE
+bool get_peak_memory(eix::UNumber *kib) {
+	struct rusage usage;
+	if(unlikely((getrusage(RUSAGE_SELF, &usage) != 0) || (usage.ru_maxrss <= 0))) {
+		return false;
+	}
+#ifdef __APPLE__
+	// Darwin counts in bytes
+	*kib = static_cast<eix::UNumber>(usage.ru_maxrss) / 1024;
+#else
+	// Linux and the BSDs count in KiB
+	*kib = static_cast<eix::UNumber>(usage.ru_maxrss);
+#endif
+	return true;
+}
+#else
+bool get_peak_memory(eix::UNumber * /* kib */) {
+	return false;
+}
+#endif
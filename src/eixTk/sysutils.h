@@ -17,6 +17,7 @@
 #include <ctime>
 
 #include "eixTk/attribute.h"
+#include "eixTk/eixint.h"
 
 /**
 Get uid of a user.
@@ -64,4 +65,20 @@ ATTRIBUTE_NONNULL_ const char *date_conv(const char *dateFormat, std::time_t myd
 **/
 ATTRIBUTE_NONNULL_ bool get_geometry(unsigned int *width, unsigned int *columns);
 
+/**
+@return the number of online processors (at least 1)
+**/
+unsigned int count_processors();
+
+/**
+Ask the kernel to read file into the page cache in the background
+(if supported) so that reading it later need not wait for the disk
+**/
+ATTRIBUTE_NONNULL_ void prefetch_file(const char *file);
+
+/**
+@return true if the peak resident set size of the process (in KiB) is known
+**/
+ATTRIBUTE_NONNULL_ bool get_peak_memory(eix::UNumber *kib);
+
 #endif  // SRC_EIXTK_SYSUTILS_H_
@@ -362,6 +362,50 @@ AddOption(BOOLEAN, "REQUIRED_USE",
 	REQUIRED_USE_DEFAULT, P_("REQUIRED_USE",
 	"If true, store/use REQUIRED_USE. Usage increases disk/memory requirements."));
 
+AddOption(BOOLEAN, "SAVE_TRIGRAMS",
+	"true", P_("SAVE_TRIGRAMS",
+	"If true, eix-update stores an index of trigrams of names, descriptions,\n"
+	"and homepages. This speeds up searching for substrings, regular\n"
+	"expressions, patterns, or fuzzy matches at the cost of a larger cachefile."));
+
+AddOption(BOOLEAN, "INCREMENTAL_UPDATE",
+	"false", P_("INCREMENTAL_UPDATE",
+	"If true, eix-update stores stamps of the categories of the caches and\n"
+	"rereads only those categories whose stamps have changed since the\n"
+	"previous run; the others are taken from the previous cachefile.\n"
+	"Only the metadata cache methods support stamps."));
+
+AddOption(INTEGER, "PARALLEL_UPDATE",
+	"1", P_("PARALLEL_UPDATE",
+	"The number of processes which eix-update uses to read the categories\n"
+	"of a cache in parallel (0 means the number of processors).\n"
+	"This has no effect with --verbose or for cache methods like eix or sqlite."));
+
+AddOption(BOOLEAN, "PREFETCH_CACHE",
+	"false", P_("PREFETCH_CACHE",
+	"If true, eix-update lets the kernel read all files of a category into\n"
+	"the page cache in the background before they are parsed.\n"
+	"This may speed up metadata cache methods on slow disks or network\n"
+	"filesystems if the files are not yet in the filesystem cache."));
+
+AddOption(BOOLEAN, "MMAP_CACHEFILE",
+	"true", P_("MMAP_CACHEFILE",
+	"If true, the eix cachefile is mapped into memory for reading.\n"
+	"Set this to false if your system or filesystem has problems with mmap."));
+
+AddOption(INTEGER, "PARALLEL_SCAN",
+	"1", P_("PARALLEL_SCAN",
+	"The number of processes which eix uses to match the packages of the\n"
+	"cachefile in parallel (0 means the number of processors).\n"
+	"This pays off only for expensive tests and needs MMAP_CACHEFILE=true."));
+
+AddOption(STRING, "STABILITY_CACHEFILE",
+	"", P_("STABILITY_CACHEFILE",
+	"If nonempty, eix keeps in this file the mask and keyword flags which it\n"
+	"calculates for tests like --stable or --non-masked, so that later runs\n"
+	"need not apply /etc/portage and the profile again. The file is not used\n"
+	"after the cachefile or some file of /etc/portage or the profile changed."));
+
 AddOption(STRING, "DEFAULT_FORMAT",
 	"normal", P_("DEFAULT_FORMAT",
 	"Defines whether --compact or --verbose is on by default."));
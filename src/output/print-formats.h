@@ -10,12 +10,18 @@
 
 #include <config.h>  // IWYU pragma: keep
 
+#include <string>
+
 #include "eixTk/attribute.h"
 #include "portage/package.h"
 
 class PrintFormats {
 	public:
 		virtual void start() {}
+		/**
+		The following packages are the matches of query (for --batch)
+		**/
+		virtual void query(const std::string& /* query */) {}
 		virtual ATTRIBUTE_NONNULL_ void package(Package *) {}
 		virtual void finish() {}
 		virtual ~PrintFormats() {}
@@ -55,6 +55,16 @@ static void add_properties(eix_proto::Properties *properties, ExtendedVersion::R
 
 void PrintProto::start() {
 	collection = new eix_proto::Collection();
+	current_query = NULLPTR;
+	category_index.clear();
+}
+
+void PrintProto::query(const string& query) {
+	if(collection == NULLPTR) {
+		start();
+	}
+	current_query = collection->add_query();
+	current_query->set_query(query);
 	category_index.clear();
 }
 
@@ -66,9 +76,15 @@ void PrintProto::package(Package *pkg) {
 	int& index = category_index[pkg->category];
 	if (index != 0) {
 		// Re-use existing category
-		category = collection->mutable_category(index - 1);
-	} else {
+		category = ((current_query != NULLPTR) ?
+			current_query->mutable_category(index - 1) :
+			collection->mutable_category(index - 1));
+	} else if(current_query != NULLPTR) {
 		// category is actually new
+		category = current_query->add_category();
+		category->set_category(pkg->category);
+		index = current_query->category_size();
+	} else {
 		category = collection->add_category();
 		category->set_category(pkg->category);
 		index = collection->category_size();
@@ -368,6 +384,7 @@ void PrintProto::finish() {
 #else
 
 void PrintProto::start() {}
+void PrintProto::query(const std::string& /* query */) {}
 void PrintProto::finish() {}
 void PrintProto::package(Package *) {
 	eix::say_error(_("protobuf format is not compiled in"));
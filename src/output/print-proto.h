@@ -26,6 +26,7 @@ class SetStability;
 
 namespace eix_proto {
 class Collection;
+class Query;
 }
 
 class PrintProto FINAL : public PrintFormats {
@@ -35,17 +36,20 @@ class PrintProto FINAL : public PrintFormats {
 		const PrintFormat *print_format;
 		const SetStability *stability;
 		eix_proto::Collection *collection;
+		eix_proto::Query *current_query;
 		typedef UNORDERED_MAP<std::string, int> CategoryIndex;
 		CategoryIndex category_index;
 
 	public:
 		ATTRIBUTE_NONNULL_ PrintProto(const DBHeader *header, VarDbPkg *vardb, const PrintFormat *printformat, const SetStability *set_stability) :
-			hdr(header), var_db_pkg(vardb), print_format(printformat), stability(set_stability), collection(NULLPTR) {}
+			hdr(header), var_db_pkg(vardb), print_format(printformat), stability(set_stability), collection(NULLPTR), current_query(NULLPTR) {}
 
-		PrintProto() : hdr(NULLPTR), var_db_pkg(NULLPTR), print_format(NULLPTR), stability(NULLPTR), collection(NULLPTR) {}
+		PrintProto() : hdr(NULLPTR), var_db_pkg(NULLPTR), print_format(NULLPTR), stability(NULLPTR), collection(NULLPTR), current_query(NULLPTR) {}
 
 		void start() OVERRIDE;
 
+		void query(const std::string& query) OVERRIDE;
+
 		ATTRIBUTE_NONNULL_ void package(Package *pkg) OVERRIDE;
 
 		void finish() OVERRIDE;
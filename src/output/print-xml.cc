@@ -41,7 +41,7 @@ const PrintXml::XmlVersion PrintXml::current;
 static void print_iuse(const IUseSet::IUseNaturalOrder& s, IUse::Flags wanted, const char *dflt);
 
 void PrintXml::runclear() {
-	started = false;
+	started = in_query = false;
 	curcat.clear();
 	count = 0;
 }
@@ -85,6 +85,22 @@ void PrintXml::start() {
 		"<eixdump version=\"%s\">") % current;
 }
 
+void PrintXml::query(const string& query) {
+	if(unlikely(!started)) {
+		start();
+	}
+	if(count) {
+		eix::say("\t</category>");
+	}
+	if(in_query) {
+		eix::say("\t</query>");
+	}
+	in_query = true;
+	curcat.clear();
+	count = 0;
+	eix::say("\t<query string=\"%s\">") % escape_xmlstring(true, query);
+}
+
 void PrintXml::finish() {
 	if(!started) {
 		return;
@@ -93,6 +109,9 @@ void PrintXml::finish() {
 	if(count) {
 		eix::say("\t</category>");
 	}
+	if(in_query) {
+		eix::say("\t</query>");
+	}
 	eix::say("</eixdump>");
 
 	runclear();
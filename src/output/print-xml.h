@@ -30,7 +30,7 @@ class SetStability;
 
 class PrintXml FINAL : public PrintFormats {
 	protected:
-		bool started;
+		bool started, in_query;
 		bool print_overlay;
 		enum { KW_NONE, KW_BOTH, KW_FULL, KW_EFF, KW_FULLS, KW_EFFS } keywords_mode;
 
@@ -50,7 +50,7 @@ class PrintXml FINAL : public PrintFormats {
 
 	public:
 		typedef eix::UNumber XmlVersion;
-		static CONSTEXPR const XmlVersion current = 16;
+		static CONSTEXPR const XmlVersion current = 17;
 
 		ATTRIBUTE_NONNULL_ void init(const DBHeader *header, VarDbPkg *vardb, const PrintFormat *printformat, const SetStability *set_stability, EixRc *eixrc, const std::string& port_dir) {
 			hdr = header;
@@ -70,6 +70,7 @@ class PrintXml FINAL : public PrintFormats {
 		}
 
 		void start() OVERRIDE;
+		void query(const std::string& query) OVERRIDE;
 		ATTRIBUTE_NONNULL_ void package(Package *pkg) OVERRIDE;
 		void finish() OVERRIDE;
 		static std::string escape_xmlstring(bool quoted, const std::string& s);
@@ -177,6 +177,7 @@ bool CascadingProfile::readremoveFiles() {
 		if(handler == NULLPTR) {
 			continue;
 		}
+		m_portagesettings->read_files.PUSH_BACK(file->name());
 		OverlayIdent& overlay(m_portagesettings->repos[file->repo_num()]);
 		overlay.readLabel();
 		if((this->*handler)(file->name(),
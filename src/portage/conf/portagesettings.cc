@@ -173,6 +173,7 @@ void PortageSettings::override_by_value(const char *var, const char *value) {
 }
 
 void PortageSettings::read_config(const string& name, const string& prefix, WordIterateMap *vars) {
+	read_files.PUSH_BACK(name);
 	(*this)["EPREFIX"] = m_eprefix;
 	VarsReader configfile(VarsReader::SUBST_VARS|VarsReader::INTO_MAP|VarsReader::APPEND_VALUES|VarsReader::ALLOW_SOURCE|VarsReader::PORTAGE_ESCAPES|VarsReader::RECURSE);
 	configfile.accumulatingKeys(default_accumulating_keys);
@@ -348,6 +349,7 @@ void PortageSettings::init(EixRc *eixrc, const ParseError *e, bool getlocal, boo
 	export_portdir_overlay = false;
 #endif
 	know_upgrade_policy = know_expands = false;
+	read_files.clear();
 	m_recurse_sets    = eixrc->getBool("RECURSIVE_SETS");
 	m_eprefixconf     = eixrc->m_eprefixconf;
 	m_eprefix         = (*eixrc)["EPREFIX"];
@@ -381,10 +383,12 @@ void PortageSettings::init(EixRc *eixrc, const ParseError *e, bool getlocal, boo
 			read_world = true;
 	}
 	if(read_world) {
+		read_files.PUSH_BACK((*eixrc)["EIX_WORLD"]);
 		if(profile->m_world.add_file((*eixrc)["EIX_WORLD"].c_str(), Mask::maskInWorld, false, parse_error)) {
 			profile->use_world = true;
 		}
 		profile->m_world.finalize();
+		read_files.PUSH_BACK((*eixrc)["EIX_WORLD_SETS"]);
 		read_world_sets((*eixrc)["EIX_WORLD_SETS"].c_str());
 	}
 
@@ -437,15 +441,20 @@ void PortageSettings::init(EixRc *eixrc, const ParseError *e, bool getlocal, boo
 				m_plain_accepted_keywords_set.INSERT(it->substr(1));
 			}
 		}
+		m_plain_accepted_keywords_table.set(m_plain_accepted_keywords_set);
 		m_local_arch_set = &m_plain_accepted_keywords_set;
 		if(as_arch < 0) {
-			m_auto_arch_set = &m_plain_accepted_keywords_set;
+			m_auto_arch_table = &m_plain_accepted_keywords_table;
 		} else {
-			m_auto_arch_set = &m_arch_set;
+			m_auto_arch_table = &m_arch_table;
 		}
 	} else {
-		m_local_arch_set = m_auto_arch_set = &m_arch_set;
-	} {
+		m_local_arch_set = &m_arch_set;
+		m_auto_arch_table = &m_arch_table;
+	}
+	m_accepted_keywords_table.set(m_accepted_keywords_set);
+	m_arch_table.set(m_arch_set);
+	{
 		// Calculate m_raised_arch by prepending ~ to every token
 		WordSet archset;
 		for(WordSet::const_iterator it(m_arch_set.begin());
@@ -640,6 +649,7 @@ void PortageSettings::read_local_sets(const WordVec& dir_list) {
 	all_set_names.INSERT("system");
 	all_set_names.INSERT("world");
 	for(WordVec::size_type i(0); likely(i != dir_list.size()); ++i) {
+		read_files.PUSH_BACK(dir_list[i]);
 		WordVec temporary_set_names;
 		pushback_files_recurse(dir_list[i], &temporary_set_names, false, NULLPTR);
 		WordVec::size_type s(set_names.size());
@@ -823,8 +833,12 @@ PortageUserConfig::~PortageUserConfig() {
 
 bool PortageUserConfig::readMasks() {
 	const ParseError *parse_error(m_settings->parse_error);
-	bool added(m_localmasks.add_file(((m_settings->m_eprefixconf) + USER_MASK_FILE).c_str(), Mask::maskMask, true, true, parse_error));
-	if(m_localmasks.add_file(((m_settings->m_eprefixconf) + USER_UNMASK_FILE).c_str(), Mask::maskUnmask, true, parse_error)) {
+	string mask_file((m_settings->m_eprefixconf) + USER_MASK_FILE);
+	string unmask_file((m_settings->m_eprefixconf) + USER_UNMASK_FILE);
+	m_settings->read_files.PUSH_BACK(mask_file);
+	m_settings->read_files.PUSH_BACK(unmask_file);
+	bool added(m_localmasks.add_file(mask_file.c_str(), Mask::maskMask, true, true, parse_error));
+	if(m_localmasks.add_file(unmask_file.c_str(), Mask::maskUnmask, true, parse_error)) {
 		added = true;
 	}
 	m_localmasks.finalize();
@@ -837,11 +851,13 @@ bool PortageUserConfig::readKeywords() {
 	LineVec lines;
 	const string& path(m_settings->m_eprefixconf);
 	string file(path + USER_KEYWORDS_FILE1);
+	m_settings->read_files.PUSH_BACK(file);
 	if(pushback_lines(file.c_str(), &lines, true)) {
 		added = pre_list.handle_file(lines, file, NULLPTR, true, false, false);
 		lines.clear();
 	}
 	file = (path + USER_KEYWORDS_FILE2);
+	m_settings->read_files.PUSH_BACK(file);
 	if(pushback_lines(file.c_str(), &lines, true)) {
 		added |= pre_list.handle_file(lines, file, NULLPTR, true, false, false);
 	}
@@ -1128,7 +1144,7 @@ bool PortageUserConfig::setKeyflags(Package *p, Keywords::Redundant check) const
 		}
 		if(kv.size() == kvsize) {
 			// Nothing has changed. In this case, we take defaults:
-			kf.set_keyflags(it->get_keyflags(m_settings->m_accepted_keywords_set));
+			kf.set_keyflags(it->get_keyflags(m_settings->m_accepted_keywords_table));
 			it->keyflags = kf;
 			it->save_keyflags(Version::SAVEKEY_ACCEPT);
 		} else {
@@ -1309,20 +1325,20 @@ void PortageUserConfig::pushback_set_accepted_keywords(WordVec *result, const Ve
 Set stability according to arch or local ACCEPT_KEYWORDS
 **/
 void PortageSettings::setKeyflags(Package *p, bool use_accepted_keywords) const {
-	const WordSet *accept_set;
+	const AcceptedKeywords *accept_table;
 	Version::SavedKeyIndex ind;
 	if(use_accepted_keywords) {
 		ind = Version::SAVEKEY_ACCEPT;
-		accept_set = &m_accepted_keywords_set;
+		accept_table = &m_accepted_keywords_table;
 	} else {
 		ind = Version::SAVEKEY_ARCH;
-		accept_set = m_auto_arch_set;
+		accept_table = m_auto_arch_table;
 	}
 	if(p->restore_keyflags(ind))
 		return;
 	get_effective_keywords_profile(p);
 	for(Package::iterator t(p->begin()); likely(t != p->end()); ++t) {
-		t->set_keyflags(*accept_set);
+		t->set_keyflags(*accept_table);
 		t->save_keyflags(ind);
 	}
 }
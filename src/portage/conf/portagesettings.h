@@ -170,7 +170,10 @@ class PortageSettings : public WordIterateMap {
 		WordVec                  m_accepted_keywords;
 		WordSet                  m_accepted_keywords_set, m_arch_set,
 		                         m_plain_accepted_keywords_set,
-		                        *m_local_arch_set, *m_auto_arch_set;
+		                        *m_local_arch_set;
+		AcceptedKeywords         m_accepted_keywords_table, m_arch_table,
+		                         m_plain_accepted_keywords_table;
+		const AcceptedKeywords  *m_auto_arch_table;
 		std::string              m_raised_arch;
 
 		MaskList<SetMask>        m_package_sets;
@@ -239,6 +242,12 @@ class PortageSettings : public WordIterateMap {
 		std::string m_eprefixaccessoverlays;
 		std::string m_world;
 
+		/**
+		The files read for the profile and make.conf and the directories
+		of sets; their stamps tell whether data derived from them is stale
+		**/
+		WordVec read_files;
+
 		PortageUserConfig *user_config;
 
 		RepoList repos;
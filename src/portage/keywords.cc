@@ -12,11 +12,13 @@
 
 #include <algorithm>
 #include <string>
+#include <vector>
 
 #include "eixTk/dialect.h"
 #include "eixTk/likely.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/unordered_map.h"
 
 using std::string;
 
@@ -57,53 +59,77 @@ inline static bool is_testing(const string& s) {
 	return (s[0] == '~');
 }
 
-KeywordsFlags::KeyType KeywordsFlags::get_keyflags(const WordSet& accepted_keywords, const string& keywords) {
-	KeyType m(KEY_EMPTY);
+WordVec KeywordIds::names;
+UNORDERED_MAP<string, KeywordIds::Id> KeywordIds::ids;
+
+KeywordIds::Id KeywordIds::intern(const string& keyword) {
+	UNORDERED_MAP<string, Id>::const_iterator it(ids.find(keyword));
+	if(likely(it != ids.end())) {
+		return it->second;
+	}
+	Id id(names.size());
+	names.PUSH_BACK(keyword);
+	ids[keyword] = id;
+	return id;
+}
+
+void KeywordIds::intern_words(List *keyword_ids, const string& keywords) {
+	keyword_ids->clear();
 	WordVec keywords_vec;
 	split_string(&keywords_vec, keywords);
 	for(WordVec::const_iterator it(keywords_vec.begin());
 		likely(it != keywords_vec.end()); ++it) {
-		if((*it)[0] == '-') {
-			if(*it == "-*") {
-				m |= KEY_MINUSASTERISK;
-			} else if(*it == "-~*") {
-				m |= KEY_MINUSUNSTABLE;
-			} else if(accepted_keywords.count(it->substr(1)) != 0) {
-				m |= KEY_MINUSKEYWORD;
-			}
-			continue;
+		keyword_ids->PUSH_BACK(intern(*it));
+	}
+}
+
+KeywordsFlags::KeyType KeywordsFlags::keyword_flags(const WordSet& accepted_keywords, const string& keyword) {
+	if(keyword[0] == '-') {
+		if(keyword == "-*") {
+			return KEY_MINUSASTERISK;
 		}
-		if(*it == "*") {
-			m |= KEY_SOMESTABLE;
-			if(find_if(accepted_keywords.begin(), accepted_keywords.end(), is_not_testing)
-				!= accepted_keywords.end()) {
-				m |= KEY_STABLE;
-			}
-			continue;
+		if(keyword == "-~*") {
+			return KEY_MINUSUNSTABLE;
 		}
-		bool found(false);
-		if(accepted_keywords.count(*it) != 0) {
-			found = true;
-			m |= (KEY_STABLE | KEY_SOMESTABLE);
+		if(accepted_keywords.count(keyword.substr(1)) != 0) {
+			return KEY_MINUSKEYWORD;
 		}
-		if((*it)[0] == '~') {
-			if(found) {
-				m |= KEY_ARCHUNSTABLE;
-			} else if(*it == "~*") {
-				m |= KEY_SOMEUNSTABLE;
-				if(find_if(accepted_keywords.begin(), accepted_keywords.end(), is_testing)
-					!= accepted_keywords.end()) {
-					m |= KEY_STABLE;
-				}
-			} else if(accepted_keywords.count(it->substr(1)) != 0) {
-				m |= KEY_ARCHUNSTABLE;
-			} else {
-				m |= KEY_ALIENUNSTABLE;
+		return KEY_EMPTY;
+	}
+	if(keyword == "*") {
+		if(find_if(accepted_keywords.begin(), accepted_keywords.end(), is_not_testing)
+			!= accepted_keywords.end()) {
+			return (KEY_SOMESTABLE | KEY_STABLE);
+		}
+		return KEY_SOMESTABLE;
+	}
+	KeyType m(KEY_EMPTY);
+	bool found(false);
+	if(accepted_keywords.count(keyword) != 0) {
+		found = true;
+		m |= (KEY_STABLE | KEY_SOMESTABLE);
+	}
+	if(keyword[0] == '~') {
+		if(found) {
+			m |= KEY_ARCHUNSTABLE;
+		} else if(keyword == "~*") {
+			m |= KEY_SOMEUNSTABLE;
+			if(find_if(accepted_keywords.begin(), accepted_keywords.end(), is_testing)
+				!= accepted_keywords.end()) {
+				m |= KEY_STABLE;
 			}
-		} else if((*it)[0] != '-') {
-			m |= (found ? KEY_ARCHSTABLE : KEY_ALIENSTABLE);
+		} else if(accepted_keywords.count(keyword.substr(1)) != 0) {
+			m |= KEY_ARCHUNSTABLE;
+		} else {
+			m |= KEY_ALIENUNSTABLE;
 		}
+	} else {
+		m |= (found ? KEY_ARCHSTABLE : KEY_ALIENSTABLE);
 	}
+	return m;
+}
+
+KeywordsFlags::KeyType KeywordsFlags::accepted_flags(const WordSet& accepted_keywords, KeyType m) {
 	if(m & KEY_STABLE) {
 		return m;
 	}
@@ -123,6 +149,57 @@ KeywordsFlags::KeyType KeywordsFlags::get_keyflags(const WordSet& accepted_keywo
 	return m;
 }
 
+KeywordsFlags::KeyType KeywordsFlags::get_keyflags(const WordSet& accepted_keywords, const string& keywords) {
+	KeyType m(KEY_EMPTY);
+	WordVec keywords_vec;
+	split_string(&keywords_vec, keywords);
+	for(WordVec::const_iterator it(keywords_vec.begin());
+		likely(it != keywords_vec.end()); ++it) {
+		m |= keyword_flags(accepted_keywords, *it);
+	}
+	return accepted_flags(accepted_keywords, m);
+}
+
+KeywordsFlags::KeyType KeywordsFlags::get_keyflags(const WordSet& accepted_keywords, const KeywordIds::List& keywords) {
+	KeyType m(KEY_EMPTY);
+	for(KeywordIds::List::const_iterator it(keywords.begin());
+		likely(it != keywords.end()); ++it) {
+		m |= keyword_flags(accepted_keywords, KeywordIds::name(*it));
+	}
+	return accepted_flags(accepted_keywords, m);
+}
+
+void AcceptedKeywords::set(const WordSet& accepted_keywords) {
+	m_accepted = accepted_keywords;
+	m_table.clear();
+	m_all_stable = (m_accepted.count("**") != 0);
+	m_stable_flags = KeywordsFlags::KEY_EMPTY;
+	if(m_accepted.count("*") != 0) {
+		m_stable_flags |= KeywordsFlags::KEY_SOMESTABLE;
+	}
+	if(m_accepted.count("~*") != 0) {
+		m_stable_flags |= KeywordsFlags::KEY_TILDESTARMATCH;
+	}
+}
+
+KeywordsFlags::KeyType AcceptedKeywords::get_keyflags(const KeywordIds::List& keywords) const {
+	KeywordsFlags::KeyType m(KeywordsFlags::KEY_EMPTY);
+	for(KeywordIds::List::const_iterator it(keywords.begin());
+		likely(it != keywords.end()); ++it) {
+		if(unlikely(*it >= m_table.size())) {
+			// Add the keywords interned since the last time
+			for(KeywordIds::Id id(m_table.size()); likely(id != KeywordIds::size()); ++id) {
+				m_table.PUSH_BACK(KeywordsFlags::keyword_flags(m_accepted, KeywordIds::name(id)));
+			}
+		}
+		m |= m_table[*it];
+	}
+	if(m_all_stable || ((m & m_stable_flags) != KeywordsFlags::KEY_EMPTY)) {
+		m |= KeywordsFlags::KEY_STABLE;
+	}
+	return m;
+}
+
 const Keywords::Redundant
 	Keywords::RED_NOTHING,
 	Keywords::RED_DOUBLE,
@@ -13,12 +13,15 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <string>
+#include <vector>
 
+#include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
 #include "eixTk/eixint.h"
 #include "eixTk/inttypes.h"
 #include "eixTk/null.h"
 #include "eixTk/stringtypes.h"
+#include "eixTk/unordered_map.h"
 
 class MaskFlags {
 	public:
@@ -137,6 +140,38 @@ inline static bool operator!=(MaskFlags const& left, MaskFlags const& right) {
 	return (left.get() != right.get());
 }
 
+/**
+All keywords met so far, each interned as a small integer (in the order
+in which they are met). Versions keep their KEYWORDS also as such ids.
+**/
+class KeywordIds {
+	public:
+		typedef eix::UNumber Id;
+		typedef std::vector<Id> List;
+
+		/**
+		@return the id of keyword; a new one if keyword is new
+		**/
+		static Id intern(const std::string& keyword);
+
+		/**
+		Set ids to the ids of the space-separated keywords
+		**/
+		ATTRIBUTE_NONNULL_ static void intern_words(List *ids, const std::string& keywords);
+
+		static const std::string& name(Id id) {
+			return names[id];
+		}
+
+		static List::size_type size() {
+			return names.size();
+		}
+
+	private:
+		static WordVec names;
+		static UNORDERED_MAP<std::string, Id> ids;
+};
+
 class KeywordsFlags {
 	public:
 		typedef eix::UChar KeyType;
@@ -155,6 +190,17 @@ class KeywordsFlags {
 			KEY_TILDESTARMATCH = KEY_SOMESTABLE|KEY_SOMEUNSTABLE;
 
 		static KeyType get_keyflags(const WordSet& accepted_keywords, const std::string& keywords);
+		static KeyType get_keyflags(const WordSet& accepted_keywords, const KeywordIds::List& keywords);
+
+		/**
+		@return the flags which keyword contributes to get_keyflags()
+		**/
+		static KeyType keyword_flags(const WordSet& accepted_keywords, const std::string& keyword);
+
+		/**
+		@return the result of get_keyflags() if the keywords contribute m
+		**/
+		static KeyType accepted_flags(const WordSet& accepted_keywords, KeyType m);
 
 		KeywordsFlags() : m_keyword(KEY_EMPTY) {
 		}
@@ -269,6 +315,36 @@ inline static bool operator!=(const KeywordsFlags& left, const KeywordsFlags& ri
 	return (left.get() != right.get());
 }
 
+/**
+A set of accepted keywords together with a table of the flags which each
+keyword id contributes to KeywordsFlags::get_keyflags().
+The table is extended when new keywords are interned.
+**/
+class AcceptedKeywords {
+	public:
+		AcceptedKeywords() : m_all_stable(false), m_stable_flags(KeywordsFlags::KEY_EMPTY) {
+		}
+
+		explicit AcceptedKeywords(const WordSet& accepted_keywords) {
+			set(accepted_keywords);
+		}
+
+		void set(const WordSet& accepted_keywords);
+
+		KeywordsFlags::KeyType get_keyflags(const KeywordIds::List& keywords) const;
+
+	private:
+		WordSet m_accepted;
+		mutable std::vector<KeywordsFlags::KeyType> m_table;
+
+		/**
+		Is everything stable (**)? Otherwise, keywords contributing some
+		of m_stable_flags are stable (* or ~*)
+		**/
+		bool m_all_stable;
+		KeywordsFlags::KeyType m_stable_flags;
+};
+
 class Keywords {
 	public:
 		typedef uint32_t Redundant;
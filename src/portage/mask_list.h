@@ -21,6 +21,7 @@
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
 #include "eixTk/forward_list.h"
+#include "eixTk/globindex.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/ptr_container.h"
@@ -69,9 +70,30 @@ template<typename m_Type> class MaskList {
 		ExactType exact_name;
 		FullType full_name;
 
+		/**
+		The keys of full_name in their order, built when first needed
+		**/
+		mutable GlobIndex full_index;
+		mutable bool full_indexed;
+
+		const GlobIndex& get_full_index() const {
+			if(unlikely(!full_indexed)) {
+				full_index.clear();
+				for(full_const_iterator it(full_name.begin());
+					likely(it != full_name.end()); ++it) {
+					full_index.add(it->first);
+				}
+				full_indexed = true;
+			}
+			return full_index;
+		}
+
 	public:
 		typedef typename eix::ptr_container<std::vector<const m_Type *> > Get;
 
+		MaskList() : full_indexed(false) {
+		}
+
 		bool empty() const {
 			return (exact_name.empty() && full_name.empty());
 		}
@@ -79,6 +101,8 @@ template<typename m_Type> class MaskList {
 		void clear() {
 			exact_name.clear();
 			full_name.clear();
+			full_index.clear();
+			full_indexed = false;
 		}
 
 		inline static bool match_full(const std::string& mask, const std::string& name) {
@@ -89,13 +113,7 @@ template<typename m_Type> class MaskList {
 			if(exact_name.count(full) != 0) {
 				return true;
 			}
-			for(full_const_iterator it(full_name.begin());
-				likely(it != full_name.end()); ++it) {
-				if(unlikely(match_full(it->first, full))) {
-					return true;
-				}
-			}
-			return false;
+			return (!full_name.empty() && get_full_index().match(full));
 		}
 
 		ATTRIBUTE_NONNULL_ bool match_name(const Package *p) const {
@@ -113,10 +131,14 @@ template<typename m_Type> class MaskList {
 
 		Get *get_full(const std::string& full) const {
 			Get *l(NULLPTR);
-			for(full_const_iterator it(full_name.begin());
-				likely(it != full_name.end()); ++it) {
-				if(unlikely(match_full(it->first, full))) {
-					push_result(&l, it->second);
+			if(!full_name.empty()) {
+				// The indices are ascending, so the order is that of full_name
+				const GlobIndex& index(get_full_index());
+				GlobIndex::Indices found;
+				index.find(&found, full);
+				for(GlobIndex::Indices::const_iterator it(found.begin());
+					likely(it != found.end()); ++it) {
+					push_result(&l, full_name.find(index.pattern(*it))->second);
 				}
 			}
 			exact_const_iterator it(exact_name.find(full));
@@ -143,6 +165,7 @@ template<typename m_Type> class MaskList {
 				return;
 			}
 			full_name[full].add(m);
+			full_indexed = false;
 		}
 
 		/**
@@ -155,9 +178,10 @@ template<typename m_Type> class MaskList {
 
 		/**
 		This can be optionally called after the last add():
-		It will release memory.
+		It will release memory and build the index of the wildcard entries.
 		**/
 		void finalize() {
+			get_full_index();
 		}
 
 		ATTRIBUTE_NONNULL_ void applyListItems(Package *p) const {
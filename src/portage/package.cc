@@ -34,6 +34,18 @@ const Package::Versioncollects
 	Package::COLLECT_HAVE_MAIN_REPO_KEY,
 	Package::COLLECT_DEFAULT;
 
+void Package::recycle() {
+	delete_and_clear();
+	name.clear();
+	desc.clear();
+	homepage.clear();
+	licenses.clear();
+	iuse.clear();
+	m_slotlist.clear();
+	m_subslot.clear();
+	defaults();
+}
+
 void Package::defaults() {
 	know_upgrade_slots = m_has_cached_slotlist =
 		m_has_cached_subslots = false;
@@ -51,7 +63,8 @@ void Package::addVersionStart(Version *version) {
 	bool have_inserted(false);
 	for(iterator i(begin()); likely(i != end()); ++i) {
 		if(!have_inserted && (*version < **i)) {
-			insert(i, version);
+			// Let i point to the same version as before
+			i = insert(i, version) + 1;
 			if(check_duplicates == DUP_NONE) {
 				return;
 			}
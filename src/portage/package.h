@@ -12,7 +12,6 @@
 
 #include <config.h>  // IWYU pragma: keep
 
-#include <list>
 #include <string>
 #include <vector>
 
@@ -82,9 +81,9 @@ class SlotList : public std::vector<SlotVersions> {
 
 /**
 A class to represent a package in portage It contains various information
-about a package, including a sorted(!) list of versions.
+about a package, including a sorted(!) vector of versions.
 **/
-class Package : public eix::ptr_container<std::list<Version *> > {
+class Package : public eix::ptr_container<std::vector<Version *> > {
 	public:
 		typedef std::vector<Version *> VerVec;
 
@@ -220,6 +219,13 @@ class Package : public eix::ptr_container<std::list<Version *> > {
 		**/
 		~Package();
 
+		/**
+		Reset to the state of a freshly constructed package.
+		The string members keep their capacity so that PackageReader
+		can refill them without new allocations.
+		**/
+		void recycle();
+
 		/**
 		Adds a version to "the versions" list,
 		updating have_duplicate_versions.
@@ -10,6 +10,8 @@
 #include "portage/set_stability.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include "eixTk/dialect.h"
+
 #ifndef ALWAYS_RECALCULATE_STABILITY
 #ifndef NDEBUG
 #ifdef EIX_PARANOIC_ASSERT
@@ -28,6 +30,7 @@
 #include "portage/keywords.h"
 #include "portage/package.h"
 #include "portage/packagetree.h"
+#include "portage/stability_cache.h"
 #include "portage/version.h"
 
 #ifndef ALWAYS_RECALCULATE_STABILITY
@@ -72,6 +75,23 @@ void SetStability::set_stability(bool get_local, Package *package) const {
 	}
 }
 
+void SetStability::get_flags(StabilityFlagsList *flags, bool get_local, Package *package) const {
+	// With filemask_is_profile the flags are restored from saved data
+	bool use_cache((m_cache != NULLPTR) && !m_filemask_is_profile);
+	if(use_cache && m_cache->get(flags, get_local, package)) {
+		return;
+	}
+	set_stability(get_local, package);
+	flags->clear();
+	for(Package::const_iterator it(package->begin());
+		likely(it != package->end()); ++it) {
+		flags->EMPLACE_BACK(StabilityFlags, (it->maskflags, it->keyflags));
+	}
+	if(use_cache) {
+		m_cache->add(get_local, package, *flags);
+	}
+}
+
 void SetStability::calc_version_flags(bool get_local, MaskFlags *maskflags, KeywordsFlags *keyflags, const Version *v, Package *p) const {
 #ifndef ALWAYS_RECALCULATE_STABILITY
 	// Can we avoid the calculation by getting the saved flags?
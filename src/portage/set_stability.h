@@ -12,7 +12,11 @@
 
 #include <config.h>  // IWYU pragma: keep
 
+#include <string>
+
 #include "eixTk/attribute.h"
+#include "eixTk/null.h"
+#include "portage/stability_cache.h"
 #include "portage/version.h"
 
 class Category;
@@ -33,6 +37,7 @@ class SetStability {
 	private:
 		const PortageSettings *portagesettings;
 		bool m_local, m_filemask_is_profile, m_always_accept_keywords;
+		StabilityCache *m_cache;
 
 #ifndef ALWAYS_RECALCULATE_STABILITY
 		/*
@@ -60,6 +65,21 @@ class SetStability {
 			m_local = localsettings;
 			m_filemask_is_profile = filemask_is_profile;
 			m_always_accept_keywords = always_accept_keywords;
+			m_cache = NULLPTR;
+		}
+
+		/**
+		Let get_flags() use and fill cache
+		**/
+		void set_cache(StabilityCache *cache) {
+			m_cache = cache;
+		}
+
+		/**
+		Write the cache if there is one
+		**/
+		ATTRIBUTE_NONNULL_ bool save_cache(std::string *errtext) const {
+			return ((m_cache == NULLPTR) || m_cache->save(errtext));
 		}
 
 		ATTRIBUTE_NONNULL_ void set_stability(bool get_local, Package *package) const;
@@ -68,6 +88,16 @@ class SetStability {
 			set_stability(m_local, package);
 		}
 
+		/**
+		Store the flags of the versions after set_stability(get_local, package).
+		If they are known from the cache, package is not modified.
+		**/
+		ATTRIBUTE_NONNULL_ void get_flags(StabilityFlagsList *flags, bool get_local, Package *package) const;
+
+		ATTRIBUTE_NONNULL_ void get_flags(StabilityFlagsList *flags, Package *package) const {
+			get_flags(flags, m_local, package);
+		}
+
 		ATTRIBUTE_NONNULL((5, 6)) void calc_version_flags(bool get_local, MaskFlags *maskflags, KeywordsFlags *keyflags, const Version *v, Package *p) const;
 
 #if 0
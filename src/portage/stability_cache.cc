@@ -0,0 +1,167 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#include "portage/stability_cache.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fstream>
+#include <string>
+
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/i18n.h"
+#include "eixTk/inttypes.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "portage/keywords.h"
+#include "portage/package.h"
+
+using std::string;
+
+static const char magic[] = "eix-stability-cache 1 ";
+static const char hexdigits[] = "0123456789abcdef";
+
+void StabilityCache::init(const string& file, const string& key) {
+	m_file = file;
+	// Two FNV-1a hashes with different offsets
+	uint32_t hash[2] = { 0x811c9dc5U, 0x050c5d1fU };
+	for(string::const_iterator it(key.begin()); likely(it != key.end()); ++it) {
+		for(unsigned int i(0); likely(i != 2); ++i) {
+			hash[i] ^= static_cast<eix::UChar>(*it);
+			hash[i] *= 0x01000193U;
+		}
+	}
+	m_key.assign(magic);
+	for(unsigned int i(0); likely(i != 2); ++i) {
+		for(int shift(28); likely(shift >= 0); shift -= 4) {
+			m_key.append(1, hexdigits[(hash[i] >> shift) & 0x0fU]);
+		}
+	}
+}
+
+void StabilityCache::entry_name(string *name, bool get_local, const Package *p) {
+	name->assign(1, (get_local ? '+' : '-'));
+	name->append(p->category);
+	name->append(1, '/');
+	name->append(p->name);
+}
+
+void StabilityCache::load() {
+	m_loaded = true;
+	std::ifstream file(m_file.c_str());
+	if(!file.is_open()) {
+		return;
+	}
+	string line;
+	if(!std::getline(file, line) || (line != m_key)) {
+		// A cache for other files or settings is stale
+		m_changed = true;
+		return;
+	}
+	while(std::getline(file, line)) {
+		string::size_type sep(line.rfind(' '));
+		if(unlikely((sep == string::npos) || (((line.size() - sep - 1) % 4) != 0))) {
+			continue;
+		}
+		string flags;
+		for(string::size_type i(sep + 1); likely(i < line.size()); i += 2) {
+			const char *high(std::strchr(hexdigits, line[i]));
+			const char *low(std::strchr(hexdigits, line[i + 1]));
+			if(unlikely((high == NULLPTR) || (low == NULLPTR))) {
+				break;
+			}
+			flags.append(1, static_cast<char>(((high - hexdigits) << 4) | (low - hexdigits)));
+		}
+		entries[line.substr(0, sep)] = flags;
+	}
+}
+
+bool StabilityCache::get(StabilityFlagsList *flags, bool get_local, const Package *p) {
+	if(unlikely(!m_loaded)) {
+		load();
+	}
+	string name;
+	entry_name(&name, get_local, p);
+	Entries::const_iterator found(entries.find(name));
+	if(found == entries.end()) {
+		return false;
+	}
+	const string& s(found->second);
+	if(unlikely(s.size() != 2 * p->size())) {
+		return false;
+	}
+	flags->clear();
+	for(string::size_type i(0); likely(i != s.size()); i += 2) {
+		flags->EMPLACE_BACK(StabilityFlags, (
+			MaskFlags(static_cast<MaskFlags::MaskType>(s[i])),
+			KeywordsFlags(static_cast<KeywordsFlags::KeyType>(s[i + 1]))));
+	}
+	return true;
+}
+
+void StabilityCache::add(bool get_local, const Package *p, const StabilityFlagsList& flags) {
+	if(unlikely(!m_loaded)) {
+		load();
+	}
+	string name;
+	entry_name(&name, get_local, p);
+	string& s(entries[name]);
+	s.clear();
+	for(StabilityFlagsList::const_iterator it(flags.begin());
+		likely(it != flags.end()); ++it) {
+		s.append(1, static_cast<char>(it->maskflags.get()));
+		s.append(1, static_cast<char>(it->keyflags.get()));
+	}
+	m_changed = true;
+}
+
+bool StabilityCache::save(string *errtext) {
+	if(!m_changed) {
+		return true;
+	}
+	m_changed = false;
+	// Write to a temporary file, so that concurrent readers see
+	// either the old or the new file
+	string tmp(eix::format("%s.%s") % m_file % getpid());
+	{
+		std::ofstream file(tmp.c_str());
+		if(unlikely(!file.is_open())) {
+			*errtext = eix::format(_("cannot write %s: %s")) % tmp % std::strerror(errno);
+			return false;
+		}
+		file << m_key << '\n';
+		for(Entries::const_iterator it(entries.begin());
+			likely(it != entries.end()); ++it) {
+			file << it->first << ' ';
+			for(string::const_iterator c(it->second.begin());
+				likely(c != it->second.end()); ++c) {
+				eix::UChar u(static_cast<eix::UChar>(*c));
+				file << hexdigits[u >> 4] << hexdigits[u & 0x0fU];
+			}
+			file << '\n';
+		}
+		file.close();
+		if(unlikely(file.fail())) {
+			*errtext = eix::format(_("cannot write %s: %s")) % tmp % std::strerror(errno);
+			std::remove(tmp.c_str());
+			return false;
+		}
+	}
+	if(unlikely(std::rename(tmp.c_str(), m_file.c_str()) != 0)) {
+		*errtext = eix::format(_("cannot write %s: %s")) % m_file % std::strerror(errno);
+		std::remove(tmp.c_str());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,82 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#ifndef SRC_PORTAGE_STABILITY_CACHE_H_
+#define SRC_PORTAGE_STABILITY_CACHE_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <string>
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
+#include "eixTk/unordered_map.h"
+#include "portage/keywords.h"
+
+class Package;
+
+/**
+The mask and keyword flags of a version as calculated by SetStability
+**/
+class StabilityFlags {
+	public:
+		MaskFlags maskflags;
+		KeywordsFlags keyflags;
+
+		StabilityFlags(MaskFlags m, KeywordsFlags k) NOEXCEPT : maskflags(m), keyflags(k) {
+		}
+};
+
+typedef std::vector<StabilityFlags> StabilityFlagsList;
+
+/**
+A file which keeps the StabilityFlags of the versions of packages across
+runs of eix. Its content is used only if it was written with the same key:
+The key must describe everything on which the flags depend, e.g. the
+stamps of the cachefile and of all files read for masks and keywords,
+and the settings.
+**/
+class StabilityCache {
+	private:
+		std::string m_file, m_key;
+		bool m_loaded, m_changed;
+
+		/**
+		The flags of the versions of a package, two bytes per version.
+		The name is the package prefixed with + (local) or - (nonlocal).
+		**/
+		typedef UNORDERED_MAP<std::string, std::string> Entries;
+		Entries entries;
+
+		void load();
+
+		ATTRIBUTE_NONNULL_ static void entry_name(std::string *name, bool get_local, const Package *p);
+
+	public:
+		StabilityCache() : m_loaded(false), m_changed(false) {
+		}
+
+		/**
+		Use file for the given key; only a hash of key is stored
+		**/
+		void init(const std::string& file, const std::string& key);
+
+		/**
+		@return false if the flags of p are not known
+		**/
+		ATTRIBUTE_NONNULL_ bool get(StabilityFlagsList *flags, bool get_local, const Package *p);
+
+		ATTRIBUTE_NONNULL_ void add(bool get_local, const Package *p, const StabilityFlagsList& flags);
+
+		/**
+		Write the file if something was added
+		**/
+		ATTRIBUTE_NONNULL_ bool save(std::string *errtext);
+};
+
+#endif  // SRC_PORTAGE_STABILITY_CACHE_H_
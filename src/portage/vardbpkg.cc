@@ -274,10 +274,9 @@ bool VarDbPkg::readUse(const Package& p, InstVersion *v) const {
 		}
 	}
 
-	IUseSet::IUseStd iuse_std(iuse_set.asStd());
 	for(WordVec::iterator it(alluse.begin());
 		likely(it != alluse.end()); ++it) {
-		if(iuse_std.count(IUse(*it)) != 0) {
+		if(iuse_set.has_name(*it)) {
 			v->usedUse.INSERT(MOVE(*it));
 		}
 	}
@@ -386,6 +385,19 @@ void VarDbPkg::readDepend(const Package& p, InstVersion *v, const DBHeader& head
 /**
 Read category from db-directory
 **/
+void VarDbPkg::readAllCategories() {
+	WordVec categories;
+	if(unlikely(!pushback_files(m_directory, &categories, NULLPTR, 2, true, false))) {
+		return;
+	}
+	for(WordVec::const_iterator it(categories.begin());
+		likely(it != categories.end()); ++it) {
+		if(installed.find(*it) == installed.end()) {
+			readCategory(it->c_str());
+		}
+	}
+}
+
 void VarDbPkg::readCategory(const char *category) {
 	/* Pointer to category DIRectory */
 	DIR *dir_category;
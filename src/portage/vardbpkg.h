@@ -81,6 +81,11 @@ class VarDbPkg {
 			}
 		}
 
+		/**
+		Read all categories of the db-directory now instead of on demand
+		**/
+		void readAllCategories();
+
 		bool care_slots() const {
 			return care_of_slots;
 		}
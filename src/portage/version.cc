@@ -10,16 +10,76 @@
 #include "portage/version.h"
 #include <config.h>  // IWYU pragma: keep
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
 #include "eixTk/stringlist.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/unordered_map.h"
 
 using std::string;
+using std::vector;
+
+WordVec IUseIds::names;
+UNORDERED_MAP<string, IUseIds::Id> IUseIds::ids;
+vector<IUseIds::Id> IUseIds::ranks;
+
+IUseIds::Id IUseIds::intern(const string& name) {
+	UNORDERED_MAP<string, Id>::const_iterator it(ids.find(name));
+	if(likely(it != ids.end())) {
+		return it->second;
+	}
+	Id id(names.size());
+	names.PUSH_BACK(name);
+	ids[name] = id;
+	return id;
+}
+
+bool IUseIds::find(Id *id, const string& name) {
+	UNORDERED_MAP<string, Id>::const_iterator it(ids.find(name));
+	if(it == ids.end()) {
+		return false;
+	}
+	*id = it->second;
+	return true;
+}
+
+/**
+Compare the names of ids with natcmp; distinct names are never equal
+**/
+class NaturalLess {
+	public:
+		explicit NaturalLess(const WordVec *names) : m_names(names) {
+		}
+
+		bool operator()(IUseIds::Id a, IUseIds::Id b) const {
+			const string& x((*m_names)[a]);
+			const string& y((*m_names)[b]);
+			eix::SignedBool c(natcmp(x, y));
+			return ((c != 0) ? (c < 0) : (x < y));
+		}
+
+	private:
+		const WordVec *m_names;
+};
+
+void IUseIds::calc_ranks() {
+	vector<Id> order(names.size());
+	for(Id i(0); likely(i != order.size()); ++i) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), NaturalLess(&names));
+	ranks.resize(order.size());
+	for(Id i(0); likely(i != order.size()); ++i) {
+		ranks[order[i]] = i;
+	}
+}
 
 const IUse::Flags
 	IUse::USEFLAGS_NIL,
@@ -92,6 +152,12 @@ const char *IUse::prefix() const {
 	}
 }
 
+IUse::IUse(const string& s) {
+	string pure(s);
+	flags = parse(&pure);
+	id = IUseIds::intern(pure);
+}
+
 string IUse::asString() const {
 	const char *p(prefix());
 	if(p == NULLPTR) {
@@ -104,10 +170,12 @@ string IUse::asString() const {
 
 IUseSet::IUseNaturalOrder IUseSet::asNaturalOrder() const {
 	IUseNaturalOrder ret;
+	ret.reserve(m_iuse.size());
 	for(IUseStd::const_iterator it(m_iuse.begin());
 		likely(it != m_iuse.end()); ++it) {
-		ret.insert(&(*it));
+		ret.PUSH_BACK(&(*it));
 	}
+	std::sort(ret.begin(), ret.end());
 	return ret;
 }
 
@@ -135,10 +203,36 @@ WordVec IUseSet::asVector() const {
 }
 
 void IUseSet::insert(const IUseStd& iuse) {
-	for(IUseStd::const_iterator it(iuse.begin());
-		likely(it != iuse.end()); ++it) {
-		insert(*it);
+	if(iuse.empty()) {
+		return;
+	}
+	if(m_iuse.empty()) {
+		m_iuse = iuse;
+		return;
+	}
+	// Linear merge of the sorted vectors
+	IUseStd merged;
+	merged.reserve(m_iuse.size() + iuse.size());
+	const IUseStd& old(m_iuse);
+	IUseStd::const_iterator a(old.begin());
+	IUseStd::const_iterator b(iuse.begin());
+	while(likely((a != old.end()) && (b != iuse.end()))) {
+		if(a->id < b->id) {
+			merged.PUSH_BACK(*a);
+			++a;
+		} else if(b->id < a->id) {
+			merged.PUSH_BACK(*b);
+			++b;
+		} else {
+			merged.PUSH_BACK(*a);
+			merged.back().flags |= b->flags;
+			++a;
+			++b;
+		}
 	}
+	merged.insert(merged.end(), a, old.end());
+	merged.insert(merged.end(), b, iuse.end());
+	m_iuse.swap(merged);
 }
 
 void IUseSet::insert(const string& iuse) {
@@ -151,18 +245,23 @@ void IUseSet::insert(const string& iuse) {
 }
 
 void IUseSet::insert(const IUse& iuse) {
-	IUseStd::iterator it(m_iuse.find(iuse));
-	if(it == m_iuse.end()) {
-		m_iuse.insert(iuse);
+	IUseStd::iterator it(std::lower_bound(m_iuse.begin(), m_iuse.end(), iuse));
+	if((it == m_iuse.end()) || (it->id != iuse.id)) {
+		m_iuse.insert(it, iuse);
 		return;
 	}
-	IUse::Flags oriflags(it->flags);
-	IUse::Flags newflags(oriflags | (iuse.flags));
-	if(newflags == oriflags) {
-		return;
+	it->flags |= iuse.flags;
+}
+
+bool IUseSet::has_name(const string& name) const {
+	string pure(name);
+	IUse::parse(&pure);
+	IUseIds::Id id;
+	if(!IUseIds::find(&id, pure)) {
+		return false;
 	}
-	m_iuse.erase(it);
-	m_iuse.EMPLACE(IUse, (iuse.name(), newflags));
+	IUseStd::const_iterator it(std::lower_bound(m_iuse.begin(), m_iuse.end(), IUse(id, IUse::USEFLAGS_NIL)));
+	return ((it != m_iuse.end()) && (it->id == id));
 }
 
 const Version::EffectiveState
@@ -179,7 +278,38 @@ Version::Version() :
 	states_effective.fill(EFFECTIVE_UNSAVED);
 }
 
+KeywordsFlags::KeyType Version::get_keyflags(const AcceptedKeywords& accepted_keywords) const {
+	if(likely(effective_state != EFFECTIVE_USED)) {
+		return accepted_keywords.get_keyflags(full_keyword_ids);
+	}
+	KeywordIds::List effective_ids;
+	KeywordIds::intern_words(&effective_ids, effective_keywords);
+	return accepted_keywords.get_keyflags(effective_ids);
+}
+
+string Version::get_full_keywords() const {
+	string keywords;
+	for(KeywordIds::List::const_iterator it(full_keyword_ids.begin());
+		likely(it != full_keyword_ids.end()); ++it) {
+		if(!keywords.empty()) {
+			keywords.append(1, ' ');
+		}
+		keywords.append(KeywordIds::name(*it));
+	}
+	return keywords;
+}
+
+void Version::get_full_keywords(WordVec *keywords) const {
+	keywords->clear();
+	keywords->reserve(full_keyword_ids.size());
+	for(KeywordIds::List::const_iterator it(full_keyword_ids.begin());
+		likely(it != full_keyword_ids.end()); ++it) {
+		keywords->PUSH_BACK(KeywordIds::name(*it));
+	}
+}
+
 void Version::modify_effective_keywords(const string& modify_keys) {
+	string full_keywords(get_full_keywords());
 	if(effective_state == EFFECTIVE_UNUSED) {
 		if(!modify_keywords(&effective_keywords, full_keywords, modify_keys)) {
 			return;
@@ -21,9 +21,11 @@
 #include "eixTk/dialect.h"
 #include "eixTk/eixarray.h"
 #include "eixTk/eixint.h"
+#include "eixTk/likely.h"
 #include "eixTk/stringlist.h"
 #include "eixTk/stringtypes.h"
 #include "eixTk/stringutils.h"
+#include "eixTk/unordered_map.h"
 #include "portage/basicversion.h"
 #include "portage/extendedversion.h"
 #include "portage/keywords.h"
@@ -33,7 +35,49 @@ class Database;
 class DBHeader;
 class OutputString;
 
-class IUse : public std::string {
+/**
+The names of all IUSE flags (without prefixes), numbered in the order in
+which they were seen first
+**/
+class IUseIds {
+	public:
+		typedef eix::UNumber Id;
+
+		/**
+		@return the id of name; a new one if name is new
+		**/
+		static Id intern(const std::string& name);
+
+		/**
+		@return true if name has an id which is then stored in id
+		**/
+		ATTRIBUTE_NONNULL_ static bool find(Id *id, const std::string& name);
+
+		static const std::string& name(Id id) {
+			return names[id];
+		}
+
+		/**
+		@return the position of the name of id in the natural order (natcmp)
+		of all names. The positions are calculated anew only if names were
+		added since the last call.
+		**/
+		static Id natural_rank(Id id) {
+			if(unlikely(ranks.size() != names.size())) {
+				calc_ranks();
+			}
+			return ranks[id];
+		}
+
+	private:
+		static WordVec names;
+		static UNORDERED_MAP<std::string, Id> ids;
+		static std::vector<Id> ranks;
+
+		static void calc_ranks();
+};
+
+class IUse {
 	public:
 		typedef eix::UChar Flags;
 		static CONSTEXPR const Flags
@@ -41,23 +85,21 @@ class IUse : public std::string {
 			USEFLAGS_NORMAL = 1,
 			USEFLAGS_PLUS   = 2,
 			USEFLAGS_MINUS  = 4;
+		IUseIds::Id id;
 		Flags flags;
 
 		ATTRIBUTE_NONNULL_ static Flags parse(std::string *s);
 
-		std::string& name() {
-			return *static_cast<std::string *>(this);
-		}
-
 		const std::string& name() const {
-			return *static_cast<const std::string *>(this);
+			return IUseIds::name(id);
 		}
 
-		explicit IUse(const std::string& s) : std::string(s) {
-			flags = parse(&name());
+		explicit IUse(const std::string& s);
+
+		IUse(const std::string& s, Flags f) : id(IUseIds::intern(s)), flags(f) {
 		}
 
-		IUse(const std::string& s, Flags f) : std::string(s), flags(f) {
+		IUse(IUseIds::Id i, Flags f) : id(i), flags(f) {
 		}
 
 		ATTRIBUTE_PURE const char *prefix() const;
@@ -65,28 +107,19 @@ class IUse : public std::string {
 		std::string asString() const;
 
 		bool operator==(const IUse& c) const {
-			return (name() == c.name());
+			return (id == c.id);
 		}
 		bool operator!=(const IUse& c) const {
-			return (name() != c.name());
+			return (id != c.id);
 		}
 		bool operator<(const IUse& c) const {
-			return (name() < c.name());
-		}
-		bool operator>(const IUse& c) const {
-			return (name() > c.name());
-		}
-		bool operator<=(const IUse& c) const {
-			return (name() <= c.name());
-		}
-		bool operator>=(const IUse& c) const {
-			return (name() >= c.name());
+			return (id < c.id);
 		}
 };
 
 class IUseNatural {
 	public:
-		IUseNatural(const IUse *use) {
+		IUseNatural(const IUse *use) NOEXCEPT {
 			m_iuse = use;
 		}
 
@@ -102,33 +135,21 @@ class IUseNatural {
 			return m_iuse->asString();
 		}
 
-		bool operator==(const IUseNatural& c) const {
-			return (name() == c.name());
-		}
-		bool operator!=(const IUseNatural& c) const {
-			return (name() != c.name());
-		}
 		bool operator<(const IUseNatural& c) const {
-			return (natcmp(name(), c.name()) < 0);
-		}
-		bool operator>(const IUseNatural& c) const {
-			return (natcmp(name(), c.name()) > 0);
-		}
-		bool operator<=(const IUseNatural& c) const {
-			return (natcmp(name(), c.name()) <= 0);
-		}
-		bool operator>=(const IUseNatural& c) const {
-			return (natcmp(name(), c.name()) >= 0);
+			return (IUseIds::natural_rank(m_iuse->id) < IUseIds::natural_rank(c.m_iuse->id));
 		}
 
 	private:
 		const IUse *m_iuse;
 };
 
+/**
+The IUSE flags of a version or package as a small vector sorted by the ids
+**/
 class IUseSet {
 	public:
-		typedef std::set<IUse> IUseStd;
-		typedef std::set<IUseNatural> IUseNaturalOrder;
+		typedef std::vector<IUse> IUseStd;
+		typedef std::vector<IUseNatural> IUseNaturalOrder;
 
 		bool empty() const {
 			return m_iuse.empty();
@@ -144,6 +165,9 @@ class IUseSet {
 
 		IUseNaturalOrder asNaturalOrder() const;
 
+		/**
+		Merge iuse which must be sorted like asStd()
+		**/
 		void insert(const IUseStd& iuse);
 
 		void insert(const IUseSet& iuse) {
@@ -156,19 +180,21 @@ class IUseSet {
 			insert(IUse(iuse));
 		}
 
+		void insert(const IUse& iuse);
+
+		/**
+		@return true if the flag name (with the prefixes of IUse) is contained
+		**/
+		bool has_name(const std::string& name) const;
+
 		std::string asString() const;
 
 		WordVec asVector() const;
 
 	protected:
 		IUseStd m_iuse;
-
-		void insert(const IUse& iuse);
 };
 
-/**
-Version expands the BasicVersion class by data relevant for versions in tree/overlays.
-**/
 class Version FINAL : public ExtendedVersion, public Keywords {
 	public:
 		typedef std::set<StringList> Reasons;
@@ -290,13 +316,24 @@ class Version FINAL : public ExtendedVersion, public Keywords {
 		}
 
 		void set_full_keywords(const std::string& keywords) {
-			full_keywords = keywords;
+			KeywordIds::intern_words(&full_keyword_ids, keywords);
 		}
 
-		std::string get_full_keywords() const {
-			return full_keywords;
+		void set_full_keyword_ids(const KeywordIds::List& ids) {
+			full_keyword_ids = ids;
 		}
 
+		const KeywordIds::List& get_full_keyword_ids() const {
+			return full_keyword_ids;
+		}
+
+		/**
+		Only the ids are stored; the text is composed when it is needed
+		**/
+		std::string get_full_keywords() const;
+
+		ATTRIBUTE_NONNULL_ void get_full_keywords(WordVec *keywords) const;
+
 		void reset_accepted_effective_keywords() {
 			effective_state = EFFECTIVE_UNUSED;
 			m_accepted_keywords.clear();
@@ -312,17 +349,19 @@ class Version FINAL : public ExtendedVersion, public Keywords {
 		void add_accepted_keywords(const std::string& accepted_keywords);
 
 		const std::string get_effective_keywords() const {
-			return ((effective_state == EFFECTIVE_USED) ? effective_keywords : full_keywords);
+			return ((effective_state == EFFECTIVE_USED) ? effective_keywords : get_full_keywords());
 		}
 
 		KeywordsFlags::KeyType get_keyflags(const WordSet& accepted_keywords) const {
 			if(effective_state == EFFECTIVE_USED) {
 				return KeywordsFlags::get_keyflags(accepted_keywords, effective_keywords);
 			}
-			return KeywordsFlags::get_keyflags(accepted_keywords, full_keywords);
+			return KeywordsFlags::get_keyflags(accepted_keywords, full_keyword_ids);
 		}
 
-		void set_keyflags(const WordSet& accepted_keywords) {
+		KeywordsFlags::KeyType get_keyflags(const AcceptedKeywords& accepted_keywords) const;
+
+		void set_keyflags(const AcceptedKeywords& accepted_keywords) {
 			keyflags.set_keyflags(get_keyflags(accepted_keywords));
 		}
 
@@ -340,7 +379,8 @@ class Version FINAL : public ExtendedVersion, public Keywords {
 
 	protected:
 		Reasons reasons;
-		std::string full_keywords, effective_keywords;
+		std::string effective_keywords;
+		KeywordIds::List full_keyword_ids;
 		EffectiveState effective_state;
 };
 
@@ -15,11 +15,15 @@
 #include <cstring>
 
 #include <string>
+#include <vector>
 
-#include "eixTk/assert.h"
+#include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
-#include "portage/package.h"
+#include "eixTk/regexp.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/stringutils.h"
 #include "search/levenshtein.h"
 
 /*
@@ -34,53 +38,73 @@ fnmatch(3) tells that this is a GNU extension.
 
 using std::string;
 
-FuzzyAlgorithm::LevenshteinMap *FuzzyAlgorithm::levenshtein_map = NULLPTR;
+Levenshtein FuzzyAlgorithm::distance = 0;
+bool FuzzyAlgorithm::have_match = false;
 
-bool BaseAlgorithm::operator()(const char *s, Package *p, bool simplify) {
-	if(can_simplify() && unlikely(!have_simplified) && likely(simplify)) {
-		have_simplified = true;
-		// cut out the first nonempty valid search string
-		for(string::size_type i = 0; i < search_string.length(); ++i) {
-			if(likely(is_valid_pkgpath(search_string[i]))) {
-				if(unlikely(i > 0)) {
-					search_string.erase(0, i);
-				}
-				break;
+/**
+Cut out the first nonempty valid search string
+**/
+static void simplify_search(string *search_string) {
+	for(string::size_type i = 0; i < search_string->length(); ++i) {
+		if(likely(is_valid_pkgpath((*search_string)[i]))) {
+			if(unlikely(i > 0)) {
+				search_string->erase(0, i);
 			}
+			break;
 		}
-		for(string::size_type i = 0; i < search_string.length(); ++i) {
-			if(unlikely(!is_valid_pkgpath(search_string[i]))) {
-				if(likely(i > 0)) {
-					search_string.erase(i);
-				}
-				break;
+	}
+	for(string::size_type i = 0; i < search_string->length(); ++i) {
+		if(unlikely(!is_valid_pkgpath((*search_string)[i]))) {
+			if(likely(i > 0)) {
+				search_string->erase(i);
 			}
+			break;
 		}
 	}
-	return (*this)(s, p);
 }
 
-void FuzzyAlgorithm::init_static() {
-	eix_assert_static(levenshtein_map == NULLPTR);
-	levenshtein_map = new LevenshteinMap;
+void BaseAlgorithm::simplify_string() {
+	if(can_simplify() && unlikely(!have_simplified)) {
+		have_simplified = true;
+		simplify_search(&search_string);
+	}
 }
 
-bool FuzzyAlgorithm::compare(Package *p1, Package *p2) {
-	return ((*levenshtein_map)[p1->category + "/" + p1->name]
-			< (*levenshtein_map)[p2->category + "/" + p2->name]);
+void BaseAlgorithm::add_search_string(WordVec *literals, bool simplify) const {
+	if(simplify && can_simplify() && !have_simplified) {
+		string s(search_string);
+		simplify_search(&s);
+		literals->PUSH_BACK(s);
+		return;
+	}
+	literals->PUSH_BACK(search_string);
 }
 
+bool RegexAlgorithm::get_literals(WordVec *literals, bool /* simplify */) const {
+	return Regex::get_literals(literals, search_string);
+}
+
+bool RegexCaseAlgorithm::get_literals(WordVec *literals, bool /* simplify */) const {
+	return Regex::get_literals(literals, search_string);
+}
+
+bool BaseAlgorithm::operator()(const char *s, Package *p, bool simplify) {
+	if(likely(simplify)) {
+		simplify_string();
+	}
+	return (*this)(s, p);
+}
 
 bool FuzzyAlgorithm::operator()(const char *s, Package *p) const {
-	eix_assert_static(levenshtein_map != NULLPTR);
-	Levenshtein d(get_levenshtein_distance(search_string.c_str(), s));
-	bool ok(d <= max_levenshteindistance);
-	if(ok) {
-		if(p != NULLPTR) {
-			(*levenshtein_map)[p->category + "/" + p->name] = d;
-		}
+	Levenshtein d;
+	if(!pattern.distance_at_most(&d, s, max_levenshteindistance)) {
+		return false;
 	}
-	return ok;
+	if(p != NULLPTR) {
+		distance = d;
+		have_match = true;
+	}
+	return true;
 }
 
 bool ExactAlgorithm::operator()(const char *s, Package * /* p */) const {
@@ -103,3 +127,218 @@ bool EndAlgorithm::operator()(const char *s, Package * /* p */) const {
 bool PatternAlgorithm::operator()(const char *s, Package * /* p */) const {
 	return (fnmatch(search_string.c_str(), s, FNMATCH_FLAGS) == 0);
 }
+
+/**
+The parts between wildcards, bracket expressions and escaped symbols
+**/
+bool PatternAlgorithm::get_literals(WordVec *literals, bool /* simplify */) const {
+	string curr;
+	for(string::size_type i(0); likely(i < search_string.size()); ++i) {
+		char c(search_string[i]);
+		switch(c) {
+			case '[':
+				if((++i < search_string.size()) && ((search_string[i] == '!') || (search_string[i] == '^'))) {
+					++i;
+				}
+				if((i < search_string.size()) && (search_string[i] == ']')) {
+					++i;
+				}
+				i = search_string.find(']', i);
+				if(i == string::npos) {
+					i = search_string.size() - 1;
+				}
+				break;
+			case '\\':
+				++i;
+				break;
+			case '*':
+			case '?':
+				break;
+			default:
+				curr.append(1, c);
+				continue;
+		}
+		if(!curr.empty()) {
+			literals->PUSH_BACK(curr);
+			curr.clear();
+		}
+	}
+	if(!curr.empty()) {
+		literals->PUSH_BACK(curr);
+	}
+	return true;
+}
+
+/**
+Back references refer to the numbers of groups and cannot be combined
+**/
+ATTRIBUTE_PURE static bool have_backreference(const string& regex) {
+	for(string::size_type i(regex.find('\\')); i != string::npos;
+		i = regex.find('\\', i + 2)) {
+		if((i + 1 < regex.size()) && my_isdigit(regex[i + 1])) {
+			return true;
+		}
+	}
+	return false;
+}
+
+BaseAlgorithm::Combine RegexAlgorithm::combine_kind() const {
+	return (have_backreference(search_string) ? COMBINE_NONE : COMBINE_REGEX);
+}
+
+BaseAlgorithm::Combine RegexCaseAlgorithm::combine_kind() const {
+	return (have_backreference(search_string) ? COMBINE_NONE : COMBINE_REGEXCASE);
+}
+
+BaseAlgorithm *BaseAlgorithm::combine(Combine kind, const WordVec& strings) {
+	BaseAlgorithm *algorithm;
+	switch(kind) {
+		case COMBINE_EXACT:
+			return new MultiExactAlgorithm(strings);
+		case COMBINE_SUBSTRING:
+		case COMBINE_BEGIN:
+		case COMBINE_END:
+			return new MultiStringAlgorithm(kind, strings);
+		case COMBINE_REGEX:
+			algorithm = new RegexAlgorithm;
+			break;
+		case COMBINE_REGEXCASE:
+			algorithm = new RegexCaseAlgorithm;
+			break;
+		default:
+			return NULLPTR;
+	}
+	// Let the regex library match the alternative of all regexes.
+	// An empty regex matches everything.
+	string alternative;
+	for(WordVec::const_iterator it(strings.begin());
+		likely(it != strings.end()); ++it) {
+		if(unlikely(it->empty())) {
+			alternative.clear();
+			break;
+		}
+		if(it != strings.begin()) {
+			alternative.append(1, '|');
+		}
+		alternative.append(1, '(');
+		alternative.append(*it);
+		alternative.append(1, ')');
+	}
+	algorithm->setString(alternative);
+	return algorithm;
+}
+
+MultiStringAlgorithm::MultiStringAlgorithm(Combine k, const WordVec& strings)
+	: kind(k), match_all(false) {
+	std::memset(char_class, 0, sizeof(char_class));
+	width = 1;
+	for(WordVec::const_iterator it(strings.begin());
+		likely(it != strings.end()); ++it) {
+		for(string::const_iterator c(it->begin()); likely(c != it->end()); ++c) {
+			unsigned char &cl(char_class[static_cast<unsigned char>(*c)]);
+			if(cl == 0) {
+				cl = static_cast<unsigned char>(width++);
+			}
+		}
+	}
+	next.assign(width, 0);
+	terminal.assign(1, false);
+	for(WordVec::const_iterator it(strings.begin());
+		likely(it != strings.end()); ++it) {
+		add_string(it->c_str(), it->size());
+	}
+	if(kind == COMBINE_SUBSTRING) {
+		add_failure_links();
+	}
+}
+
+void MultiStringAlgorithm::add_string(const char *s, string::size_type len) {
+	if(unlikely(len == 0)) {
+		match_all = true;
+		return;
+	}
+	Node node(0);
+	for(string::size_type i(0); likely(i < len); ++i) {
+		// For end-of-string matching the trie contains the reversed strings
+		char c((kind == COMBINE_END) ? s[len - 1 - i] : s[i]);
+		Node index(node * width + char_class[static_cast<unsigned char>(c)]);
+		if(next[index] == 0) {
+			next[index] = terminal.size();
+			terminal.PUSH_BACK(false);
+			next.resize(next.size() + width, 0);
+		}
+		node = next[index];
+	}
+	terminal[node] = true;
+}
+
+/**
+Turn the trie into the Aho-Corasick automaton by completing
+all transitions in breadth-first order (so that the transitions of the
+failure node, which is less deep, are already complete).
+**/
+void MultiStringAlgorithm::add_failure_links() {
+	std::vector<Node> failure(terminal.size(), 0);
+	std::vector<Node> queue;
+	for(Node c(0); c < width; ++c) {
+		Node child(next[c]);
+		if(child != 0) {
+			queue.PUSH_BACK(child);
+		}
+	}
+	for(std::vector<Node>::size_type i(0); i < queue.size(); ++i) {
+		Node node(queue[i]);
+		Node fail(failure[node]);
+		if(terminal[fail]) {
+			terminal[node] = true;
+		}
+		for(Node c(0); c < width; ++c) {
+			Node &child(next[node * width + c]);
+			Node fail_child(next[fail * width + c]);
+			if(child == 0) {
+				child = fail_child;
+				continue;
+			}
+			failure[child] = fail_child;
+			queue.PUSH_BACK(child);
+		}
+	}
+}
+
+bool MultiStringAlgorithm::operator()(const char *s, Package * /* p */) const {
+	if(unlikely(match_all)) {
+		return true;
+	}
+	Node node(0);
+	if(kind == COMBINE_SUBSTRING) {
+		for(; *s != '\0'; ++s) {
+			node = step(node, *s);
+			if(terminal[node]) {
+				return true;
+			}
+		}
+		return false;
+	}
+	if(kind == COMBINE_BEGIN) {
+		for(; *s != '\0'; ++s) {
+			node = step(node, *s);
+			if(node == 0) {
+				return false;
+			}
+			if(terminal[node]) {
+				return true;
+			}
+		}
+		return false;
+	}
+	for(const char *e(s + std::strlen(s)); e != s; ) {
+		node = step(node, *(--e));
+		if(node == 0) {
+			return false;
+		}
+		if(terminal[node]) {
+			return true;
+		}
+	}
+	return false;
+}
@@ -13,11 +13,14 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <string>
+#include <vector>
 
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
+#include "eixTk/null.h"
 #include "eixTk/regexp.h"
-#include "eixTk/unordered_map.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/stringutils.h"
 #include "search/levenshtein.h"
 
 class Package;
@@ -37,7 +40,32 @@ class BaseAlgorithm {
 			return true;
 		}
 
+		/**
+		Cut out the first nonempty valid search string (only once)
+		**/
+		void simplify_string();
+
+		/**
+		Add the search string as used for simplified fields (if simplify)
+		or for the other fields to literals
+		**/
+		ATTRIBUTE_NONNULL_ void add_search_string(WordVec *literals, bool simplify) const;
+
 	public:
+		/**
+		Kinds of algorithms for which several search strings
+		can be matched at once
+		**/
+		enum Combine {
+			COMBINE_NONE,
+			COMBINE_EXACT,
+			COMBINE_SUBSTRING,
+			COMBINE_BEGIN,
+			COMBINE_END,
+			COMBINE_REGEX,
+			COMBINE_REGEXCASE
+		};
+
 		virtual void setString(const std::string& s) {
 			search_string = s;
 			have_simplified = false;
@@ -49,6 +77,70 @@ class BaseAlgorithm {
 		ATTRIBUTE_NONNULL((2)) virtual bool operator()(const char *s, Package *p) const = 0;
 
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package *p, bool simplify);
+
+		/**
+		Add strings which must all occur in every matching string.
+		@arg simplify whether also fields with simplification are searched
+		@return false if no such strings are known
+		**/
+		ATTRIBUTE_NONNULL_ virtual bool get_literals(WordVec * /* literals */, bool /* simplify */) const {
+			return false;
+		}
+
+		/**
+		For approximate matching: Every matching string differs from
+		*literal by at most *max_errors edit operations.
+		@return false if this is not known
+		**/
+		ATTRIBUTE_NONNULL_ virtual bool get_approximate(std::string * /* literal */, Levenshtein * /* max_errors */) const {
+			return false;
+		}
+
+		/**
+		@return true if only the search string itself can match
+		**/
+		virtual bool is_exact() const {
+			return false;
+		}
+
+		/**
+		@return true if matching records something about the package
+		so that the test must not be skipped or moved
+		**/
+		virtual bool keep_order() const {
+			return false;
+		}
+
+		/**
+		@return the search string as used for the simplified fields
+		**/
+		const std::string& simplified_string() {
+			simplify_string();
+			return search_string;
+		}
+
+		/**
+		@return the search string as used for the (simplified) fields
+		**/
+		const std::string& combine_string(bool simplify) {
+			if(simplify) {
+				simplify_string();
+			}
+			return search_string;
+		}
+
+		/**
+		@return the kind for combining the search string with others
+		**/
+		virtual Combine combine_kind() const {
+			return COMBINE_NONE;
+		}
+
+		/**
+		@return a new algorithm which matches if at least one of the
+		search strings matches by an algorithm of the given kind
+		**/
+		static BaseAlgorithm *combine(Combine kind, const WordVec& strings);
 };
 
 /**
@@ -71,6 +163,10 @@ class RegexAlgorithm FINAL : public BaseAlgorithm {
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE {
 			return re.match(s);
 		}
+
+		ATTRIBUTE_NONNULL_ bool get_literals(WordVec *literals, bool simplify) const OVERRIDE;
+
+		Combine combine_kind() const OVERRIDE;
 };
 
 /**
@@ -93,6 +189,10 @@ class RegexCaseAlgorithm FINAL : public BaseAlgorithm {
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE {
 			return re.match(s);
 		}
+
+		ATTRIBUTE_NONNULL_ bool get_literals(WordVec *literals, bool simplify) const OVERRIDE;
+
+		Combine combine_kind() const OVERRIDE;
 };
 
 /**
@@ -100,6 +200,19 @@ exact string matching
 **/
 class ExactAlgorithm FINAL : public BaseAlgorithm {
 	public:
+		ATTRIBUTE_NONNULL_ bool get_literals(WordVec *literals, bool simplify) const OVERRIDE {
+			add_search_string(literals, simplify);
+			return true;
+		}
+
+		bool is_exact() const OVERRIDE {
+			return true;
+		}
+
+		Combine combine_kind() const OVERRIDE {
+			return COMBINE_EXACT;
+		}
+
 		ATTRIBUTE_NONNULL((2)) ATTRIBUTE_PURE bool operator()(const char *s, Package * /* p */) const OVERRIDE;
 };
 
@@ -108,8 +221,18 @@ substring matching
 **/
 class SubstringAlgorithm FINAL : public BaseAlgorithm {
 	public:
+		ATTRIBUTE_NONNULL_ bool get_literals(WordVec *literals, bool simplify) const OVERRIDE {
+			add_search_string(literals, simplify);
+			return true;
+		}
+
+		Combine combine_kind() const OVERRIDE {
+			return COMBINE_SUBSTRING;
+		}
+
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE {
-			return (std::string(s).find(search_string) != std::string::npos);
+			return (search_string.empty() ||
+				(find_substring(s, search_string.c_str(), search_string.size()) != NULLPTR));
 		}
 };
 
@@ -118,6 +241,15 @@ begin-of-string matching
 **/
 class BeginAlgorithm FINAL : public BaseAlgorithm {
 	public:
+		ATTRIBUTE_NONNULL_ bool get_literals(WordVec *literals, bool simplify) const OVERRIDE {
+			add_search_string(literals, simplify);
+			return true;
+		}
+
+		Combine combine_kind() const OVERRIDE {
+			return COMBINE_BEGIN;
+		}
+
 		ATTRIBUTE_NONNULL((2)) ATTRIBUTE_PURE bool operator()(const char *s, Package * /* p */) const OVERRIDE;
 };
 
@@ -126,9 +258,76 @@ end-of-string matching
 **/
 class EndAlgorithm FINAL : public BaseAlgorithm {
 	public:
+		ATTRIBUTE_NONNULL_ bool get_literals(WordVec *literals, bool simplify) const OVERRIDE {
+			add_search_string(literals, simplify);
+			return true;
+		}
+
+		Combine combine_kind() const OVERRIDE {
+			return COMBINE_END;
+		}
+
 		ATTRIBUTE_NONNULL((2)) ATTRIBUTE_PURE bool operator()(const char *s, Package * /* p */) const OVERRIDE;
 };
 
+/**
+Exact matching of several strings at once
+**/
+class MultiExactAlgorithm FINAL : public BaseAlgorithm {
+	private:
+		WordUnorderedSet strings;
+
+	protected:
+		bool can_simplify() const OVERRIDE {
+			return false;
+		}
+
+	public:
+		explicit MultiExactAlgorithm(const WordVec& s)
+			: strings(s.begin(), s.end()) {
+		}
+
+		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE {
+			return (strings.count(s) != 0);
+		}
+};
+
+/**
+Substring, begin-of-string, or end-of-string matching of several strings
+at once with a deterministic automaton (Aho-Corasick for substrings,
+a trie for the other kinds). The transitions are stored in a table
+of nodes times classes of characters; class 0 are all characters
+which occur in no search string. Node 0 is the root.
+**/
+class MultiStringAlgorithm FINAL : public BaseAlgorithm {
+	private:
+		typedef std::vector<unsigned int>::size_type Node;
+
+		Combine kind;
+		bool match_all;
+		unsigned char char_class[256];
+		Node width;
+		std::vector<Node> next;
+		std::vector<bool> terminal;
+
+		ATTRIBUTE_NONNULL_ void add_string(const char *s, std::string::size_type len);
+		void add_failure_links();
+
+		Node step(Node node, char c) const {
+			return next[node * width + char_class[static_cast<unsigned char>(c)]];
+		}
+
+	protected:
+		bool can_simplify() const OVERRIDE {
+			return false;
+		}
+
+	public:
+		MultiStringAlgorithm(Combine k, const WordVec& strings);
+
+		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE;
+};
+
 /**
 Store distance to searchstring in Package and sort out packages with a
 higher distance than max_levenshteindistance.
@@ -136,14 +335,17 @@ higher distance than max_levenshteindistance.
 class FuzzyAlgorithm FINAL : public BaseAlgorithm {
 	protected:
 		Levenshtein max_levenshteindistance;
+		LevenshteinPattern pattern;
+
+		/**
+		The distance of the last match of the current package
+		**/
+		static Levenshtein distance;
 
 		/**
-		FIXME: We need to have a package->levenshtein mapping that we can
-		access from the static FuzzyAlgorithm::compare.
-		I really don't know how to do this ..
+		Whether there was some match at all
 		**/
-		typedef UNORDERED_MAP<std::string, Levenshtein> LevenshteinMap;
-		static LevenshteinMap *levenshtein_map;
+		static bool have_match;
 
 		bool can_simplify() const OVERRIDE {
 			return false;
@@ -153,15 +355,56 @@ class FuzzyAlgorithm FINAL : public BaseAlgorithm {
 		explicit FuzzyAlgorithm(Levenshtein max) : max_levenshteindistance(max) {
 		}
 
+		void setString(const std::string& s) OVERRIDE {
+			search_string = s;
+			have_simplified = false;
+			pattern.set_pattern(search_string);
+		}
+
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package *p) const OVERRIDE;
 
-		ATTRIBUTE_NONNULL_ static bool compare(Package *p1, Package *p2);
+		ATTRIBUTE_NONNULL_ bool get_approximate(std::string *literal, Levenshtein *max_errors) const OVERRIDE {
+			*literal = search_string;
+			*max_errors = max_levenshteindistance;
+			return true;
+		}
+
+		bool keep_order() const OVERRIDE {
+			return true;
+		}
+
+		/**
+		Call this before testing a package; a package not matched by
+		any FuzzyAlgorithm has distance 0.
+		**/
+		static void reset_distance() {
+			distance = 0;
+		}
+
+		/**
+		@return the distance of the last match of the current package
+		**/
+		static Levenshtein get_distance() {
+			return distance;
+		}
 
 		static bool sort_by_levenshtein() {
-			return (!levenshtein_map->empty());
+			return have_match;
 		}
 
-		static void init_static();
+		/**
+		Act as if some FuzzyAlgorithm has matched (e.g. in another process)
+		**/
+		static void set_sort_by_levenshtein() {
+			have_match = true;
+		}
+
+		/**
+		Call this before the packages are tested for a new query
+		**/
+		static void reset_sort_by_levenshtein() {
+			have_match = false;
+		}
 };
 
 /**
@@ -175,6 +418,8 @@ class PatternAlgorithm FINAL : public BaseAlgorithm {
 
 	public:
 		ATTRIBUTE_NONNULL((2)) bool operator()(const char *s, Package * /* p */) const OVERRIDE;
+
+		ATTRIBUTE_NONNULL_ bool get_literals(WordVec *literals, bool simplify) const OVERRIDE;
 };
 
 #endif  // SRC_SEARCH_ALGORITHMS_H_
@@ -13,55 +13,124 @@
 
 #include <cstring>
 
-#include <algorithm>
-#include <utility>  // std::swap since C++11
+#include <string>
 #include <vector>
 
+#include "eixTk/inttypes.h"
 #include "eixTk/likely.h"
 
+using std::string;
 using std::vector;
 
-using std::min;
-using std::swap;
+const Levenshtein LevenshteinPattern::word_bits;
+
+void LevenshteinPattern::set_pattern(const string& pattern) {
+	length = pattern.size();
+	blocks = (length + word_bits - 1) / word_bits;
+	peq.assign(256 * blocks, 0);
+	for(Levenshtein i(0); likely(i != length); ++i) {
+		peq[static_cast<unsigned char>(pattern[i]) * blocks + i / word_bits] |=
+			(Word(1) << (i % word_bits));
+	}
+	vp.resize(blocks);
+	vn.resize(blocks);
+	last_bit = ((length == 0) ? 0 : (Word(1) << ((length - 1) % word_bits)));
+}
 
 /**
-Calculates the Levenshtein distance of two strings
-@param str_a string a
-@param str_b string b
-@return Levenshtein distance of strings a and b
+The column of the dynamic programming matrix is kept as bit vectors of
+vertical deltas (vp for +1, vn for -1); the score is its last entry.
+Since neighbouring columns differ by at most 1, the distance is at least
+score - (characters left), so we can stop as soon as this exceeds max.
 **/
-Levenshtein get_levenshtein_distance(const char *str_a, const char *str_b) {
-	// We save space https://de.wikipedia.org/wiki/Hirschberg-Algorithmus
-	size_t n(std::strlen(str_a));
-	size_t m(std::strlen(str_b));
-	if(n > m) {
-		swap(n, m);
-		swap(str_a, str_b);
+bool LevenshteinPattern::distance_at_most(Levenshtein *d, const char *str, Levenshtein max) const {
+	Levenshtein left(std::strlen(str));
+	if(unlikely(length == 0)) {
+		*d = left;
+		return (left <= max);
 	}
-	if(n == 0) {
-		return m;
+	if(((left > length) ? (left - length) : (length - left)) > max) {
+		return false;
 	}
-
-	vector<Levenshtein> arr(n + 1);
-	for(Levenshtein i(0); likely(i <= n); ++i) {
-		arr[i] = i;  // start with 0 and add 1 (insert) for each char
-	}
-	for(; m > 0; ++str_a, --m) {
-		vector<Levenshtein>::iterator it(arr.begin());
-		Levenshtein sub((*it)++);  // add 1 (delete *str_a)
-		for(size_t i(0); i < n; ++i) {
-			Levenshtein c(*it);
-			// +1: insert str_b[i] or delete *str_a
-			c = min(c, *(++it)) + 1;
-			if (str_b[i] != *str_a) {
-				++sub;  // +1: Substitute
+	Levenshtein score(length);
+	if(likely(blocks == 1)) {
+		const Word *eqs(&(peq[0]));
+		Word p(~Word(0)), n(0);
+		for(; likely(*str != '\0'); ++str) {
+			--left;
+			Word eq(eqs[static_cast<unsigned char>(*str)]);
+			Word xv(eq | n);
+			Word xh((((eq & p) + p) ^ p) | eq);
+			Word hp(n | ~(xh | p));
+			Word hn(p & xh);
+			if((hp & last_bit) != 0) {
+				++score;
+			} else if((hn & last_bit) != 0) {
+				--score;
+			}
+			// The first row has horizontal deltas +1
+			hp = (hp << 1) | 1;
+			hn <<= 1;
+			p = hn | ~(xv | hp);
+			n = hp & xv;
+			if((score > left) && (score - left > max)) {
+				return false;
+			}
+		}
+	} else {
+		for(Levenshtein b(0); likely(b != blocks); ++b) {
+			vp[b] = ~Word(0);
+			vn[b] = 0;
+		}
+		const Word high_bit(Word(1) << (word_bits - 1));
+		for(; likely(*str != '\0'); ++str) {
+			--left;
+			const Word *eqs(&(peq[static_cast<unsigned char>(*str) * blocks]));
+			// The horizontal delta passed from one block to the next
+			int h(1);
+			for(Levenshtein b(0); likely(b != blocks); ++b) {
+				Word eq(eqs[b]);
+				Word p(vp[b]), n(vn[b]);
+				Word xv(eq | n);
+				if(h < 0) {
+					eq |= 1;
+				}
+				Word xh((((eq & p) + p) ^ p) | eq);
+				Word hp(n | ~(xh | p));
+				Word hn(p & xh);
+				Word bit((b + 1 == blocks) ? last_bit : high_bit);
+				int h_out(((hp & bit) != 0) ? 1 : (((hn & bit) != 0) ? -1 : 0));
+				hp <<= 1;
+				hn <<= 1;
+				if(h < 0) {
+					hn |= 1;
+				} else if(h > 0) {
+					hp |= 1;
+				}
+				vp[b] = hn | ~(xv | hp);
+				vn[b] = hp & xv;
+				h = h_out;
 			}
-			if (c > sub) {
-				c = sub;
+			if(h > 0) {
+				++score;
+			} else if(h < 0) {
+				--score;
+			}
+			if((score > left) && (score - left > max)) {
+				return false;
 			}
-			sub = *it;
-			*it = c;
 		}
 	}
-	return arr[n];
+	*d = score;
+	return (score <= max);
+}
+
+Levenshtein LevenshteinPattern::distance(const char *str) const {
+	Levenshtein d;
+	distance_at_most(&d, str, ~Levenshtein(0));
+	return d;
+}
+
+Levenshtein get_levenshtein_distance(const char *str_a, const char *str_b) {
+	return LevenshteinPattern(str_a).distance(str_b);
 }
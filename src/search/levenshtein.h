@@ -13,17 +13,73 @@
 
 #include <sys/types.h>
 
+#include <string>
+#include <vector>
+
 #include "eixTk/attribute.h"
+#include "eixTk/inttypes.h"
 
 typedef size_t Levenshtein;
 
+/**
+Calculates Levenshtein distances of strings to a fixed pattern with the
+bit-parallel algorithm of Myers in the version of Hyyrö for edit distances:
+One machine word for up to 64 characters of the pattern, several blocks
+of words for longer patterns. The buffers are reused for every string.
+**/
+class LevenshteinPattern {
+	public:
+		LevenshteinPattern() : length(0), blocks(0), last_bit(0) {
+		}
+
+		explicit LevenshteinPattern(const std::string& pattern) {
+			set_pattern(pattern);
+		}
+
+		void set_pattern(const std::string& pattern);
+
+		/**
+		Calculate the distance only as long as it can be at most max
+		@param d the distance is stored here if true is returned
+		@return false if the distance is larger than max
+		**/
+		ATTRIBUTE_NONNULL_ bool distance_at_most(Levenshtein *d, const char *str, Levenshtein max) const;
+
+		/**
+		@return Levenshtein distance of str and the pattern
+		**/
+		ATTRIBUTE_NONNULL_ Levenshtein distance(const char *str) const;
+
+	private:
+		typedef uint64_t Word;
+		static const Levenshtein word_bits = 64;
+
+		Levenshtein length, blocks;
+
+		/**
+		The bit of the last character of the pattern in its block
+		**/
+		Word last_bit;
+
+		/**
+		The bitmasks of the positions of each character in the pattern:
+		peq[c * blocks + b] is for character c in block b
+		**/
+		std::vector<Word> peq;
+
+		/**
+		The positive and negative vertical deltas (scratch buffers)
+		**/
+		mutable std::vector<Word> vp, vn;
+};
+
 /**
 Calculates the Levenshtein distance of two strings.
-Reference: http://www.merriampark.com/ld.htm
+Reference: https://en.wikipedia.org/wiki/Levenshtein_distance
 @param str_a string a
 @param str_b string b
 @return Levenshtein distance of strings a and b
 **/
-ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE Levenshtein get_levenshtein_distance(const char *str_a, const char *str_b);
+ATTRIBUTE_NONNULL_ Levenshtein get_levenshtein_distance(const char *str_a, const char *str_b);
 
 #endif  // SRC_SEARCH_LEVENSHTEIN_H_
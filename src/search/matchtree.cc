@@ -14,14 +14,24 @@
 #include <cstdlib>
 #endif
 
+#include <algorithm>
+#include <map>
 #include <stack>
+#include <utility>
+#include <vector>
 
+#include "database/package_reader.h"
 #include "eixTk/formated.h"
 #include "eixTk/i18n.h"
 #include "eixTk/likely.h"
 #include "eixTk/null.h"
+#include "search/algorithms.h"
 #include "search/packagetest.h"
 
+const MatchStep::Index
+	MatchStep::ACCEPT,
+	MatchStep::REJECT;
+
 bool MatchAtom::match(PackageReader * /* p */) {
 #ifdef DEBUG_MATCHTREE
 	eix::print(m_negate ? " '!' " : " '' ");
@@ -30,6 +40,10 @@ bool MatchAtom::match(PackageReader * /* p */) {
 	return !m_negate;
 }
 
+bool MatchAtom::get_pins(PackageReader::Pins * /* pins */) const {
+	return false;
+}
+
 MatchAtomOperator::~MatchAtomOperator() {
 	delete m_left;
 	delete m_right;
@@ -68,6 +82,27 @@ bool MatchAtomOperator::match(PackageReader *p) {
 	return is_match;
 }
 
+bool MatchAtomOperator::get_pins(PackageReader::Pins *pins) const {
+	if(m_negate) {
+		return false;
+	}
+	PackageReader::Pins left;
+	if(m_operator == AtomAnd) {
+		// It suffices that one side is restricted
+		if((m_left != NULLPTR) && m_left->get_pins(&left)) {
+			pins->insert(pins->end(), left.begin(), left.end());
+			return true;
+		}
+		return ((m_right != NULLPTR) && m_right->get_pins(pins));
+	}
+	if(unlikely(m_left == NULLPTR) || unlikely(m_right == NULLPTR) ||
+		!m_left->get_pins(&left) || !m_right->get_pins(pins)) {
+		return false;
+	}
+	pins->insert(pins->end(), left.begin(), left.end());
+	return true;
+}
+
 MatchAtomTest::~MatchAtomTest() {
 #ifndef DEBUG_MATCHTREE
 	delete m_test;
@@ -100,6 +135,19 @@ bool MatchAtomTest::match(PackageReader *p) {
 #endif
 }
 
+bool MatchAtomTest::get_pins(PackageReader::Pins *pins) const {
+	if(m_negate) {
+		return false;
+	}
+	PackageReader::Pins test;
+	if((m_test != NULLPTR) && m_test->get_pins(&test)) {
+		pins->insert(pins->end(), test.begin(), test.end());
+		return true;
+	}
+	return ((m_pipe != NULLPTR) && ((*m_pipe) != NULLPTR) &&
+		(*m_pipe)->get_pins(pins));
+}
+
 void MatchAtomTest::set_test(PackageTest *gtest) {
 #ifdef DEBUG_MATCHTREE
 	static int t_count(0);
@@ -117,6 +165,7 @@ void MatchAtomTest::set_test(PackageTest *gtest) {
 
 MatchTree::MatchTree(bool default_is_or) {
 	root = piperoot = NULLPTR;
+	compiled = false;
 	default_operator = (default_is_or ? MatchAtomOperator::AtomOr : MatchAtomOperator::AtomAnd);
 	local_negate = local_finished = false;
 	parser_stack.push(MatchParseData(&root));
@@ -124,15 +173,222 @@ MatchTree::MatchTree(bool default_is_or) {
 
 MatchTree::~MatchTree() {
 	end_parse();
+	delete_combined();
 	delete root;
 	delete piperoot;
 }
 
+void MatchTree::delete_combined() {
+	for(std::vector<MatchAtom *>::iterator it(combined_atoms.begin());
+		likely(it != combined_atoms.end()); ++it) {
+		delete *it;
+	}
+	combined_atoms.clear();
+}
+
 bool MatchTree::match(PackageReader *p) {
-	return ((root == NULLPTR) || root->match(p));
+	if(unlikely(!compiled)) {
+		compile();
+	}
+	MatchStep::Index i(entry);
+	for(;;) {
+		if(i == MatchStep::ACCEPT) {
+			return true;
+		}
+		if(i == MatchStep::REJECT) {
+			return false;
+		}
+		const MatchStep& step(program[i]);
+		i = (step.test->match(p) ? step.on_true : step.on_false);
+	}
+}
+
+void MatchTree::compile() {
+	compiled = true;
+	program.clear();
+	delete_combined();
+	entry = compile(root, MatchStep::ACCEPT, MatchStep::REJECT);
+}
+
+MatchStep::Index MatchTree::compile(MatchAtom *atom, MatchStep::Index on_true, MatchStep::Index on_false) {
+	if(atom == NULLPTR) {
+		return on_true;
+	}
+	if(atom->m_negate) {
+		MatchStep::Index swap(on_true);
+		on_true = on_false;
+		on_false = swap;
+	}
+	MatchAtomTest *test(atom->as_test());
+	if(test != NULLPTR) {
+		return compile_test(test, on_true, on_false);
+	}
+	MatchAtomOperator *op(atom->as_operator());
+	if(op == NULLPTR) {
+		return on_true;
+	}
+	Operands operands;
+	add_operands(&operands, op->m_left, op->m_operator);
+	add_operands(&operands, op->m_right, op->m_operator);
+	bool keep(false);
+	for(Operands::const_iterator it(operands.begin());
+		likely(it != operands.end()); ++it) {
+		if(keep_order(it->second)) {
+			keep = true;
+			break;
+		}
+	}
+	if(!keep) {
+		if(op->m_operator == MatchAtomOperator::AtomOr) {
+			combine_operands(&operands);
+		}
+		// The operators are commutative, but the later operands need not
+		// be evaluated: Put the cheap ones first
+		std::stable_sort(operands.begin(), operands.end(), CompareCost());
+	}
+	// The steps are appended "backwards" so that the targets are known
+	MatchStep::Index target((op->m_operator == MatchAtomOperator::AtomAnd) ?
+		on_true : on_false);
+	for(Operands::size_type i(operands.size()); likely(i != 0); ) {
+		MatchAtom *operand(operands[--i].second);
+		if(op->m_operator == MatchAtomOperator::AtomAnd) {
+			target = compile(operand, target, on_false);
+		} else {
+			target = compile(operand, on_true, target);
+		}
+	}
+	return target;
+}
+
+void MatchTree::add_operands(Operands *operands, MatchAtom *atom, MatchAtomOperator::AtomOperator op) {
+	if(atom != NULLPTR) {
+		MatchAtomOperator *sub(atom->as_operator());
+		if((sub != NULLPTR) && (!sub->m_negate) && (sub->m_operator == op)) {
+			add_operands(operands, sub->m_left, op);
+			add_operands(operands, sub->m_right, op);
+			return;
+		}
+	}
+	operands->PUSH_BACK(Operand(cost(atom), atom));
+}
+
+/**
+Replace all unnegated simple string tests of the same field and kind
+by a single test which matches all their search strings at once.
+The combined test takes the place of the first of them.
+**/
+void MatchTree::combine_operands(Operands *operands) {
+	typedef std::pair<PackageTest::MatchField, BaseAlgorithm::Combine> Key;
+	typedef std::map<Key, std::vector<Operands::size_type> > Groups;
+	Groups groups;
+	for(Operands::size_type i(0); likely(i < operands->size()); ++i) {
+		MatchAtom *atom((*operands)[i].second);
+		MatchAtomTest *test((atom == NULLPTR) ? NULLPTR : atom->as_test());
+		if((test == NULLPTR) || test->m_negate ||
+			(test->m_pipe != NULLPTR) || (test->m_test == NULLPTR)) {
+			continue;
+		}
+		BaseAlgorithm::Combine kind(test->m_test->combine_kind());
+		if(kind != BaseAlgorithm::COMBINE_NONE) {
+			groups[Key(test->m_test->get_field(), kind)].PUSH_BACK(i);
+		}
+	}
+	std::vector<bool> removed(operands->size(), false);
+	bool have_removed(false);
+	for(Groups::const_iterator it(groups.begin()); likely(it != groups.end()); ++it) {
+		const std::vector<Operands::size_type>& group(it->second);
+		if(group.size() <= 1) {
+			continue;
+		}
+		std::vector<PackageTest *> tests;
+		for(std::vector<Operands::size_type>::const_iterator i(group.begin());
+			likely(i != group.end()); ++i) {
+			tests.PUSH_BACK((*operands)[*i].second->as_test()->m_test);
+			removed[*i] = true;
+		}
+		MatchAtomTest *combined(new MatchAtomTest);
+		combined->set_test(PackageTest::combine(tests));
+		combined_atoms.PUSH_BACK(combined);
+		(*operands)[group[0]] = Operand(cost(combined), combined);
+		removed[group[0]] = false;
+		have_removed = true;
+	}
+	if(!have_removed) {
+		return;
+	}
+	Operands::size_type j(0);
+	for(Operands::size_type i(0); likely(i < operands->size()); ++i) {
+		if(!removed[i]) {
+			(*operands)[j++] = (*operands)[i];
+		}
+	}
+	operands->resize(j);
+}
+
+MatchStep::Index MatchTree::compile_test(MatchAtomTest *atom, MatchStep::Index on_true, MatchStep::Index on_false) {
+	PackageTest *test(atom->m_test);
+	if(likely(atom->m_pipe == NULLPTR)) {
+		return add_step(test, on_true, on_false);
+	}
+	MatchAtom *pipe(*(atom->m_pipe));
+	if(pipe == NULLPTR) {
+		return on_false;
+	}
+	if((test == NULLPTR) || keep_order(pipe) || test->keep_order() ||
+		(cost(pipe) <= test->cost())) {
+		return compile(pipe, add_step(test, on_true, on_false), on_false);
+	}
+	return add_step(test, compile(pipe, on_true, on_false), on_false);
+}
+
+MatchStep::Index MatchTree::add_step(PackageTest *test, MatchStep::Index on_true, MatchStep::Index on_false) {
+	if(test == NULLPTR) {
+		return on_true;
+	}
+	program.PUSH_BACK(MatchStep(test, on_true, on_false));
+	return program.size() - 1;
+}
+
+unsigned int MatchTree::cost(MatchAtom *atom) {
+	if(atom == NULLPTR) {
+		return 0;
+	}
+	MatchAtomTest *test(atom->as_test());
+	if(test != NULLPTR) {
+		unsigned int c((test->m_test == NULLPTR) ? 0 : test->m_test->cost());
+		if(test->m_pipe != NULLPTR) {
+			c += cost(*(test->m_pipe));
+		}
+		return c;
+	}
+	MatchAtomOperator *op(atom->as_operator());
+	if(op == NULLPTR) {
+		return 0;
+	}
+	return cost(op->m_left) + cost(op->m_right);
+}
+
+bool MatchTree::keep_order(MatchAtom *atom) {
+	if(atom == NULLPTR) {
+		return false;
+	}
+	MatchAtomTest *test(atom->as_test());
+	if(test != NULLPTR) {
+		return (((test->m_test != NULLPTR) && test->m_test->keep_order()) ||
+			((test->m_pipe != NULLPTR) && keep_order(*(test->m_pipe))));
+	}
+	MatchAtomOperator *op(atom->as_operator());
+	return ((op != NULLPTR) &&
+		(keep_order(op->m_left) || keep_order(op->m_right)));
+}
+
+bool MatchTree::get_pins(PackageReader::Pins *pins) const {
+	pins->clear();
+	return ((root != NULLPTR) && root->get_pins(pins));
 }
 
 void MatchTree::set_pipetest(PackageTest *gtest) {
+	compiled = false;
 	MatchAtomTest *p(new MatchAtomTest);
 	p->set_test(gtest);
 	if(unlikely(piperoot == NULLPTR)) {
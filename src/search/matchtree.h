@@ -11,7 +11,10 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <stack>
+#include <utility>
+#include <vector>
 
+#include "database/package_reader.h"
 #include "eixTk/attribute.h"
 #include "eixTk/dialect.h"
 #include "eixTk/null.h"
@@ -19,7 +22,6 @@
 class MatchAtomOperator;
 class MatchAtomTest;
 class MatchTree;
-class PackageReader;
 class PackageTest;
 
 class MatchAtom {
@@ -47,6 +49,13 @@ class MatchAtom {
 		**/
 		ATTRIBUTE_PURE virtual bool match(PackageReader *p);
 
+		/**
+		Add (recursively if necessary) all packages which can match.
+		@return false if this cannot be expressed by pins; then the
+		content of pins is unspecified
+		**/
+		ATTRIBUTE_NONNULL_ virtual bool get_pins(PackageReader::Pins *pins) const;
+
 		virtual MatchAtomOperator *as_operator() {
 			return NULLPTR;
 		}
@@ -72,6 +81,8 @@ class MatchAtomOperator : public MatchAtom {
 
 		bool match(PackageReader *p) OVERRIDE;
 
+		ATTRIBUTE_NONNULL_ bool get_pins(PackageReader::Pins *pins) const OVERRIDE;
+
 		MatchAtomOperator *as_operator() OVERRIDE {
 			return this;
 		}
@@ -91,6 +102,8 @@ class MatchAtomTest : public MatchAtom {
 
 		bool match(PackageReader *p) OVERRIDE;
 
+		ATTRIBUTE_NONNULL_ bool get_pins(PackageReader::Pins *pins) const OVERRIDE;
+
 		void set_test(PackageTest *gtest);
 
 		MatchAtomTest *as_test() OVERRIDE {
@@ -98,6 +111,25 @@ class MatchAtomTest : public MatchAtom {
 		}
 };
 
+/**
+One instruction of the flattened MatchTree:
+Run test and continue with the step on_true or on_false, respectively
+**/
+class MatchStep {
+	public:
+		typedef unsigned int Index;
+		static CONSTEXPR const Index
+			ACCEPT = static_cast<Index>(-1),  ///< The package matches
+			REJECT = static_cast<Index>(-2);  ///< The package does not match
+
+		PackageTest *test;
+		Index on_true, on_false;
+
+		ATTRIBUTE_NONNULL((2)) MatchStep(PackageTest *t, Index t_next, Index f_next)
+			: test(t), on_true(t_next), on_false(f_next) {
+		}
+};
+
 class MatchParseData {
 	public:
 		/**
@@ -132,6 +164,34 @@ class MatchTree {
 		MatchAtom *root, *piperoot;
 		MatchAtomOperator::AtomOperator default_operator;
 
+		/**
+		The tree compiled into a flat program, starting at entry.
+		Cheap tests are moved to the front so that expensive tests
+		(and reading of expensive attributes) are avoided if possible.
+		**/
+		std::vector<MatchStep> program;
+		MatchStep::Index entry;
+		bool compiled;
+
+		/**
+		Tests generated by combining several tests; these are not
+		contained in the tree and must be deleted separately
+		**/
+		std::vector<MatchAtom *> combined_atoms;
+
+		/**
+		The operands of a chain of the same operator with their costs
+		**/
+		typedef std::pair<unsigned int, MatchAtom *> Operand;
+		typedef std::vector<Operand> Operands;
+
+		class CompareCost {
+			public:
+				bool operator()(const Operand& a, const Operand& b) const {
+					return (a.first < b.first);
+				}
+		};
+
 		/**
 		The following flags must be carefully honoured and updated
 		in every public parse_* function
@@ -169,6 +229,34 @@ class MatchTree {
 		**/
 		void parse_closeforce();
 
+		void compile();
+
+		void delete_combined();
+
+		ATTRIBUTE_NONNULL((1)) static void add_operands(Operands *operands, MatchAtom *atom, MatchAtomOperator::AtomOperator op);
+
+		ATTRIBUTE_NONNULL_ void combine_operands(Operands *operands);
+
+		/**
+		Append the steps for atom to program.
+		@return the index of the first step to execute
+		**/
+		MatchStep::Index compile(MatchAtom *atom, MatchStep::Index on_true, MatchStep::Index on_false);
+
+		MatchStep::Index compile_test(MatchAtomTest *atom, MatchStep::Index on_true, MatchStep::Index on_false);
+
+		MatchStep::Index add_step(PackageTest *test, MatchStep::Index on_true, MatchStep::Index on_false);
+
+		/**
+		@return a rough estimate of the time needed to match atom
+		**/
+		static unsigned int cost(MatchAtom *atom);
+
+		/**
+		@return true if atom contains a test which must not be moved
+		**/
+		static bool keep_order(MatchAtom *atom);
+
 	public:
 		explicit MatchTree(bool default_is_or);
 
@@ -176,6 +264,12 @@ class MatchTree {
 
 		bool match(PackageReader *p);
 
+		/**
+		Collect all packages which can possibly match.
+		@return false if all packages must be tested
+		**/
+		ATTRIBUTE_NONNULL_ bool get_pins(PackageReader::Pins *pins) const;
+
 		void set_pipetest(PackageTest *gtest);
 
 		void parse_test(PackageTest *gtest, bool with_pipe);
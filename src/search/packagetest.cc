@@ -11,9 +11,13 @@
 #include <config.h>  // IWYU pragma: keep
 
 #include <string>
+#include <vector>
 
+#include "database/package_fields.h"
 #include "database/package_reader.h"
+#include "database/trigrams.h"
 #include "eixTk/attribute.h"
+#include "eixTk/dialect.h"
 #include "eixTk/eixint.h"
 #include "eixTk/filenames.h"
 #include "eixTk/likely.h"
@@ -31,8 +35,10 @@
 #include "portage/extendedversion.h"
 #include "portage/mask_list.h"
 #include "portage/package.h"
+#include "portage/stability_cache.h"
 #include "portage/vardbpkg.h"
 #include "search/algorithms.h"
+#include "search/levenshtein.h"
 #include "search/nowarn.h"
 
 using std::string;
@@ -96,7 +102,7 @@ const PackageTest::TestStability
 
 NowarnMaskList *PackageTest::nowarn_list = NULLPTR;
 
-ATTRIBUTE_NONNULL_ ATTRIBUTE_PURE static bool stabilitytest(const Package *p, PackageTest::TestStability what);
+ATTRIBUTE_PURE static bool stabilitytest(const StabilityFlagsList& flags, PackageTest::TestStability what);
 ATTRIBUTE_NONNULL_ inline static void get_p(Package **p, PackageReader *pkg);
 
 PackageTest::PackageTest(VarDbPkg *vdb, PortageSettings *p, const PrintFormat *f, const SetStability *set_stability, const DBHeader *dbheader, const ParseError *e) {
@@ -194,15 +200,98 @@ void PackageTest::finalize() {
 	calculateNeeds();
 }
 
+/**
+The weights only need to be roughly proportional:
+Reading versions dominates reading the other attributes,
+looking into the vardb dominates reading the database, and
+calculating masks, keywords or redundancies dominates everything.
+**/
+unsigned int PackageTest::cost() const {
+	unsigned int c((need < PackageReader::VERSIONS) ?
+		static_cast<unsigned int>(need) : 16);
+	if(algorithm != NULLPTR) {
+		c += 1;
+	}
+	if(((field & (USE_ENABLED | USE_DISABLED | INST_EAPI | INST_SLOT | INST_FULLSLOT | DEPSI)) != NONE) ||
+		installed ||
+		(in_overlay_inst_list != NULLPTR) ||
+		(from_overlay_inst_list != NULLPTR) ||
+		(from_foreign_overlay_inst_list != NULLPTR) ||
+		(restrictions != ExtendedVersion::RESTRICT_NONE) ||
+		(properties != ExtendedVersion::PROPERTIES_NONE) ||
+		(binarynum != 0)) {
+		c += 32;
+	}
+	if(obsolete || upgrade || world || worldset ||
+		(marked_list != NULLPTR) ||
+		(test_instability != STABLE_NONE) ||
+		(test_stability_default != STABLE_NONE) ||
+		(test_stability_local != STABLE_NONE) ||
+		(test_stability_nonlocal != STABLE_NONE)) {
+		c += 128;
+	}
+	return c;
+}
+
+bool PackageTest::keep_order() const {
+	return ((algorithm != NULLPTR) && algorithm->keep_order());
+}
+
+BaseAlgorithm::Combine PackageTest::combine_kind() const {
+	if((algorithm == NULLPTR) ||
+		overlay || obsolete || upgrade || installed || slotted ||
+		world || worldset || have_virtual || have_nonvirtual ||
+		dup_versions || dup_packages ||
+		(overlay_list != NULLPTR) || (overlay_only_list != NULLPTR) ||
+		(in_overlay_inst_list != NULLPTR) ||
+		(from_overlay_inst_list != NULLPTR) ||
+		(from_foreign_overlay_inst_list != NULLPTR) ||
+		(marked_list != NULLPTR) ||
+		(restrictions != ExtendedVersion::RESTRICT_NONE) ||
+		(properties != ExtendedVersion::PROPERTIES_NONE) ||
+		(binarynum != 0) ||
+		(test_instability != STABLE_NONE) ||
+		(test_stability_default != STABLE_NONE) ||
+		(test_stability_local != STABLE_NONE) ||
+		(test_stability_nonlocal != STABLE_NONE)) {
+		return BaseAlgorithm::COMBINE_NONE;
+	}
+	// stringMatch() simplifies the search string when it first meets
+	// a category: the combined test could differ for the first package
+	if(((field & NAME) == NONE) &&
+		((field & (CATEGORY | CATEGORY_NAME)) != NONE)) {
+		return BaseAlgorithm::COMBINE_NONE;
+	}
+	return algorithm->combine_kind();
+}
+
+PackageTest *PackageTest::combine(const std::vector<PackageTest *>& tests) {
+	const PackageTest *first(tests[0]);
+	// If the name is matched, this happens first and simplifies the string
+	bool simplify((first->field & NAME) != NONE);
+	WordVec strings;
+	for(std::vector<PackageTest *>::const_iterator it(tests.begin());
+		likely(it != tests.end()); ++it) {
+		strings.PUSH_BACK((*it)->algorithm->combine_string(simplify));
+	}
+	PackageTest *test(new PackageTest(first->vardbpkg, first->portagesettings,
+		first->print_format, first->stability, first->header,
+		first->parse_error));
+	test->field = first->field;
+	test->setAlgorithm(BaseAlgorithm::combine(first->combine_kind(), strings));
+	test->know_pattern = true;
+	return test;
+}
+
 /**
 @return true if pkg matches test
 **/
-bool PackageTest::stringMatch(Package *pkg) const {
+bool PackageTest::stringMatch(Package *pkg, PackageFields *fields) const {
 	if((((field & NAME) != NONE) && (*algorithm)(pkg->name.c_str(), pkg, true))
 	|| (((field & DESCRIPTION) != NONE)  && (*algorithm)(pkg->desc.c_str(), pkg))
 	|| (((field & LICENSE) != NONE) && (*algorithm)(pkg->licenses.c_str(), pkg))
 	|| (((field & CATEGORY) != NONE) && (*algorithm)(pkg->category.c_str(), pkg, true))
-	|| (((field & CATEGORY_NAME) != NONE) && (*algorithm)((pkg->category + "/" + pkg->name).c_str(), pkg, true))
+	|| (((field & CATEGORY_NAME) != NONE) && (*algorithm)(fields->category_name(pkg).c_str(), pkg, true))
 	|| (((field & HOMEPAGE) != NONE) && (*algorithm)(pkg->homepage.c_str(), pkg))) {
 		return true;
 	}
@@ -224,17 +313,19 @@ bool PackageTest::stringMatch(Package *pkg) const {
 	}
 
 	if((field & SLOT) != NONE) {
-		for(Package::iterator it(pkg->begin());
-			likely(it != pkg->end()); ++it) {
-			if((*algorithm)(it->get_longslot().c_str(), pkg))
+		const WordVec& slots(fields->longslots(pkg));
+		for(WordVec::const_iterator it(slots.begin());
+			likely(it != slots.end()); ++it) {
+			if((*algorithm)(it->c_str(), pkg))
 				return true;
 		}
 	}
 
 	if((field & FULLSLOT) != NONE) {
-		for(Package::iterator it(pkg->begin());
-			likely(it != pkg->end()); ++it) {
-			if((*algorithm)(it->get_longfullslot().c_str(), pkg))
+		const WordVec& slots(fields->longfullslots(pkg));
+		for(WordVec::const_iterator it(slots.begin());
+			likely(it != slots.end()); ++it) {
+			if((*algorithm)(it->c_str(), pkg))
 				return true;
 		}
 	}
@@ -249,31 +340,39 @@ bool PackageTest::stringMatch(Package *pkg) const {
 	}
 
 	if((field & DEPSA) != NONE) {
-		bool depend((field & DEPENDA) != NONE);
-		bool rdepend((field & RDEPENDA) != NONE);
-		bool pdepend((field & PDEPENDA) != NONE);
-		bool bdepend((field & BDEPENDA) != NONE);
-		bool idepend((field & IDEPENDA) != NONE);
-		for(Package::iterator it(pkg->begin());
-			likely(it != pkg->end()); ++it) {
-			const Depend &dep(it->depend);
-			if((depend && (*algorithm)(dep.get_depend().c_str(), pkg))
-			|| (rdepend && (*algorithm)(dep.get_rdepend().c_str(), pkg))
-			|| (pdepend && (*algorithm)(dep.get_pdepend().c_str(), pkg))
-			|| (bdepend && (*algorithm)(dep.get_bdepend().c_str(), pkg))
-			|| (idepend && (*algorithm)(dep.get_idepend().c_str(), pkg))) {
-				return true;
+		// The versions are tested in order, for each version the kinds
+		const WordVec *deps[PackageFields::DEPEND_KINDS];
+		unsigned int kinds(0);
+		if((field & DEPENDA) != NONE) {
+			deps[kinds++] = &(fields->depends(pkg, PackageFields::DEPEND));
+		}
+		if((field & RDEPENDA) != NONE) {
+			deps[kinds++] = &(fields->depends(pkg, PackageFields::RDEPEND));
+		}
+		if((field & PDEPENDA) != NONE) {
+			deps[kinds++] = &(fields->depends(pkg, PackageFields::PDEPEND));
+		}
+		if((field & BDEPENDA) != NONE) {
+			deps[kinds++] = &(fields->depends(pkg, PackageFields::BDEPEND));
+		}
+		if((field & IDEPENDA) != NONE) {
+			deps[kinds++] = &(fields->depends(pkg, PackageFields::IDEPEND));
+		}
+		WordVec::size_type versions(deps[0]->size());
+		for(WordVec::size_type i(0); likely(i != versions); ++i) {
+			for(unsigned int k(0); likely(k != kinds); ++k) {
+				if((*algorithm)((*(deps[k]))[i].c_str(), pkg)) {
+					return true;
+				}
 			}
 		}
 	}
 
 	if((field & SET) != NONE) {
-		WordSet setnames;
-		portagesettings->get_setnames(&setnames, pkg);
-		for(WordSet::const_iterator it(setnames.begin());
+		const WordVec& setnames(fields->setnames(pkg, portagesettings));
+		for(WordVec::const_iterator it(setnames.begin());
 			likely(it != setnames.end()); ++it) {
-			if((*algorithm)(it->c_str(), NULLPTR)
-			|| (*algorithm)((string("@") + *it).c_str(), NULLPTR)) {
+			if((*algorithm)(it->c_str(), NULLPTR)) {
 				return true;
 			}
 		}
@@ -455,11 +554,12 @@ bool PackageTest::have_redundant(const Package& p, Keywords::Redundant r) const
 	return false;
 }
 
-static bool stabilitytest(const Package *p, PackageTest::TestStability what) {
+static bool stabilitytest(const StabilityFlagsList& flags, PackageTest::TestStability what) {
 	if(likely(what == PackageTest::STABLE_NONE)) {
 		return true;
 	}
-	for(Package::const_iterator it(p->begin()); likely(it != p->end()); ++it) {
+	for(StabilityFlagsList::const_iterator it(flags.begin());
+		likely(it != flags.end()); ++it) {
 		if((what & PackageTest::STABLE_SYSTEMPROFILE) != PackageTest::STABLE_NONE) {
 			if((what & PackageTest::STABLE_SYSTEM) != PackageTest::STABLE_NONE) {
 				if(!it->maskflags.isSystem()) {
@@ -496,19 +596,20 @@ static bool stabilitytest(const Package *p, PackageTest::TestStability what) {
 	return false;
 }
 
-bool PackageTest::instabilitytest(const Package *p, TestStability what) const {
+bool PackageTest::instabilitytest(const Package *p, const StabilityFlagsList& flags, TestStability what) const {
 	if(likely(what == STABLE_NONE)) {
 		return true;
 	}
-	for(Package::const_iterator it(p->begin()); likely(it != p->end()); ++it) {
+	StabilityFlagsList::const_iterator f(flags.begin());
+	for(Package::const_iterator it(p->begin()); likely(it != p->end()); ++it, ++f) {
 		TestStability have(STABLE_NONE);
-		if(it->maskflags.isHardMasked()) {
+		if(f->maskflags.isHardMasked()) {
 			have |= (STABLE_FULL | STABLE_NONMASKED);
 		}
-		if(!it->keyflags.isStable()) {
+		if(!f->keyflags.isStable()) {
 			have |= STABLE_FULL;
 		}
-		if(it->keyflags.isUnstable()) {
+		if(f->keyflags.isUnstable()) {
 			have |= (STABLE_FULL | STABLE_TESTING);
 		}
 		if((what & have) != what) {
@@ -527,8 +628,71 @@ inline static void get_p(Package **p, PackageReader *pkg) {
 	}
 }
 
+bool PackageTest::get_pins(PackageReader::Pins *pins) const {
+	if((algorithm == NULLPTR) || (field == NONE)) {
+		return false;
+	}
+	if(!algorithm->is_exact() || ((field & ~(NAME | CATEGORY | CATEGORY_NAME)) != NONE)) {
+		return get_trigram_pins(pins);
+	}
+	// All these fields match against the simplified string
+	const string& s(algorithm->simplified_string());
+	if((field & NAME) != NONE) {
+		pins->PUSH_BACK(PackageReader::Pin(string(), s));
+	}
+	if(((field & CATEGORY) != NONE) && likely(!s.empty())) {
+		pins->PUSH_BACK(PackageReader::Pin(s, string()));
+	}
+	if((field & CATEGORY_NAME) != NONE) {
+		string::size_type i(s.find('/'));
+		if((i != string::npos) && likely(i != 0) && likely(i + 1 != s.size())) {
+			pins->PUSH_BACK(PackageReader::Pin(s.substr(0, i), s.substr(i + 1)));
+		}
+	}
+	return true;
+}
+
+/**
+Every match in the fields covered by the trigram index must contain
+all trigrams of the literals of the search string.
+For approximate matching, each edit operation can destroy at most 3 of the
+trigrams of the search string, so a match must contain all but 3 * errors.
+**/
+bool PackageTest::get_trigram_pins(PackageReader::Pins *pins) const {
+	if((field & ~(NAME | DESCRIPTION | CATEGORY | CATEGORY_NAME | HOMEPAGE)) != NONE) {
+		return false;
+	}
+	string literal;
+	Levenshtein max_errors;
+	if(algorithm->get_approximate(&literal, &max_errors)) {
+		Trigrams::Keys keys;
+		Trigrams::add(&keys, literal);
+		Trigrams::normalize(&keys);
+		if((max_errors > keys.size() / 3) || (keys.size() == 3 * max_errors)) {
+			return false;
+		}
+		pins->PUSH_BACK(PackageReader::Pin(keys, keys.size() - 3 * max_errors));
+		return true;
+	}
+	WordVec literals;
+	if(!algorithm->get_literals(&literals, (field & (NAME | CATEGORY | CATEGORY_NAME)) != NONE)) {
+		return false;
+	}
+	Trigrams::Keys keys;
+	for(WordVec::const_iterator it(literals.begin()); likely(it != literals.end()); ++it) {
+		Trigrams::add(&keys, *it);
+	}
+	if(keys.empty()) {
+		return false;
+	}
+	Trigrams::normalize(&keys);
+	pins->PUSH_BACK(PackageReader::Pin(keys));
+	return true;
+}
+
 bool PackageTest::match(PackageReader *pkg) const {
 	Package *p(NULLPTR);
+	StabilityFlagsList flags;
 
 	pkg->read(need);
 
@@ -556,12 +720,14 @@ bool PackageTest::match(PackageReader *pkg) const {
 	   depending on which type of stability you want.
 	   (Default means according to LOCAL_PORTAGE_CONFIG,
 	   Nonlocal means as with LOCAL_PORTAGE_CONFIG=false)
+	   If only the flags are needed, rather call stability->get_flags()
+	   which can take them from the STABILITY_CACHEFILE.
 	3. Once more: remember to modify "need" in CalculateNeeds() to
 	   ensure the versions really have been read for the package. */
 
 	if(unlikely(algorithm != NULLPTR)) {
 		get_p(&p, pkg);
-		if(!stringMatch(p)) {
+		if(!stringMatch(p, pkg->fields())) {
 			return false;
 		}
 	}
@@ -929,8 +1095,8 @@ bool PackageTest::match(PackageReader *pkg) const {
 	if(unlikely(test_stability_default != STABLE_NONE)) {
 		// --stable, --testing, --non-masked, --system
 		get_p(&p, pkg);
-		StabilityDefault(p);
-		if(!stabilitytest(p, test_stability_default)) {
+		stability->get_flags(&flags, p);
+		if(!stabilitytest(flags, test_stability_default)) {
 			return false;
 		}
 	}
@@ -938,8 +1104,8 @@ bool PackageTest::match(PackageReader *pkg) const {
 	if(unlikely(test_stability_local != STABLE_NONE)) {
 		// --stable+, --testing+, --non-masked+, --system+
 		get_p(&p, pkg);
-		StabilityLocal(p);
-		if(!stabilitytest(p, test_stability_local)) {
+		stability->get_flags(&flags, true, p);
+		if(!stabilitytest(flags, test_stability_local)) {
 			return false;
 		}
 	}
@@ -947,8 +1113,8 @@ bool PackageTest::match(PackageReader *pkg) const {
 	if(unlikely(test_stability_nonlocal != STABLE_NONE)) {
 		// --stable-, --testing-, --non-masked-, --system-
 		get_p(&p, pkg);
-		StabilityNonlocal(p);
-		if(!stabilitytest(p, test_stability_nonlocal)) {
+		stability->get_flags(&flags, false, p);
+		if(!stabilitytest(flags, test_stability_nonlocal)) {
 			return false;
 		}
 	}
@@ -956,8 +1122,8 @@ bool PackageTest::match(PackageReader *pkg) const {
 	if(unlikely(test_instability != STABLE_NONE)) {
 	// --installed-unstable --installed-testing --installed-masked
 		get_p(&p, pkg);
-		StabilityNonlocal(p);
-		if(!instabilitytest(p, test_instability)) {
+		stability->get_flags(&flags, false, p);
+		if(!instabilitytest(p, flags, test_instability)) {
 			return false;
 		}
 	}
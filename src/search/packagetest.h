@@ -26,13 +26,15 @@
 #include "portage/keywords.h"
 #include "portage/package.h"
 #include "portage/set_stability.h"
+#include "portage/stability_cache.h"
+#include "search/algorithms.h"
 #include "search/redundancy.h"
 
-class BaseAlgorithm;
 class Mask;
 class MatcherAlgorithm;
 class MatcherField;
 class NowarnMaskList;
+class PackageFields;
 class ParseError;
 class PortageSettings;
 class PrintFormat;
@@ -132,11 +134,44 @@ class PackageTest {
 
 		bool match(PackageReader *pkg) const;
 
+		/**
+		Add to pins all packages which can possibly match.
+		@return false if this cannot be expressed by pins
+		**/
+		ATTRIBUTE_NONNULL_ bool get_pins(PackageReader::Pins *pins) const;
+
 		/**
 		Set defaults (e.g. matchfield if unspecified), calculate needs
 		**/
 		void finalize();
 
+		/**
+		@return a rough estimate of the time needed by match()
+		**/
+		ATTRIBUTE_PURE unsigned int cost() const;
+
+		/**
+		@return true if match() must not be skipped or moved
+		relative to other tests, e.g. since it records a fuzzy distance
+		**/
+		bool keep_order() const;
+
+		/**
+		@return the kind of the algorithm if this is a pure string test
+		which can be combined with others of the same field and kind
+		**/
+		BaseAlgorithm::Combine combine_kind() const;
+
+		MatchField get_field() const {
+			return field;
+		}
+
+		/**
+		@return a new test which matches if one of tests matches;
+		all tests must have the same field and combine_kind()
+		**/
+		static PackageTest *combine(const std::vector<PackageTest *>& tests);
+
 		/*
 		The constructor of the class *must* set the least restrictive choice.
 		Since --selected --world must act like --selected, the less restrictive
@@ -385,7 +420,9 @@ class PackageTest {
 		static MatchAlgorithm get_matchalgorithm(const char *p, MatchField field);
 		static void parse_field_specification(const std::string& spec, MatchField *or_field, MatchField *and_field, MatchField *not_field);
 
-		ATTRIBUTE_NONNULL_ bool stringMatch(Package *pkg) const;
+		ATTRIBUTE_NONNULL_ bool stringMatch(Package *pkg, PackageFields *fields) const;
+
+		ATTRIBUTE_NONNULL_ bool get_trigram_pins(PackageReader::Pins *pins) const;
 
 		void setNeeds(const PackageReader::Attributes i) {
 			if(need < i) {
@@ -400,7 +437,7 @@ class PackageTest {
 
 		bool have_redundant(const Package& p, Keywords::Redundant r, const RedAtom& t) const;
 		bool have_redundant(const Package& p, Keywords::Redundant r) const;
-		ATTRIBUTE_NONNULL_ bool instabilitytest(const Package *p, TestStability what) const;
+		ATTRIBUTE_NONNULL_ bool instabilitytest(const Package *p, const StabilityFlagsList& flags, TestStability what) const;
 
 		static Keywords::Redundant nowarn_keywords(const Package& p);
 		static Keywords::Redundant nowarn_mask(const Package& p);
@@ -424,7 +424,6 @@ void PackageTest::setPattern(const char *p) {
 
 void PackageTest::init_static() {
 	NowarnMask::init_static();
-	FuzzyAlgorithm::init_static();
 	init_match_field_map();
 	init_match_algorithm_map();
 }
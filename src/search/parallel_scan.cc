@@ -0,0 +1,235 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#include "search/parallel_scan.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+
+#include <string>
+#include <vector>
+
+#include "database/header.h"
+#include "database/io.h"
+#include "database/package_reader.h"
+#include "eixTk/attribute.h"
+#include "eixTk/diagnostics.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringutils.h"
+#include "portage/package.h"
+#include "search/algorithms.h"
+#include "search/levenshtein.h"
+#include "search/matchtree.h"
+
+using std::string;
+using std::vector;
+
+/**
+The worker: Output the matching packages as lines "distance category/name"
+(distance is that of the fuzzy search) and finally a line "+" if some
+fuzzy search matched
+**/
+ATTRIBUTE_NORETURN static void scan_part(int fd, Database *db, const DBHeader& header, PortageSettings *ps, MatchTree *matchtree, const PackageReader::Pins& pins) {
+	// Warnings are output by the main process
+	int null_fd(open("/dev/null", O_WRONLY));
+	if(likely(null_fd >= 0)) {
+		dup2(null_fd, 1);
+		dup2(null_fd, 2);
+	}
+	PackageReader reader(db, header, ps);
+	reader.restrict_to(pins);
+	string out;
+	while(likely(reader.next())) {
+		FuzzyAlgorithm::reset_distance();
+		if(matchtree->match(&reader)) {
+			if(unlikely(!reader.read(PackageReader::NAME))) {
+				break;
+			}
+			out.append(eix::format("%s ") % FuzzyAlgorithm::get_distance());
+			out.append(reader.category());
+			out.append(1, '/');
+			out.append(reader.get()->name);
+			out.append(1, '\n');
+		}
+		if(unlikely(!reader.skip())) {
+			break;
+		}
+	}
+	if(unlikely(reader.get_errtext() != NULLPTR)) {
+		_exit(EXIT_FAILURE);
+	}
+	if(FuzzyAlgorithm::sort_by_levenshtein()) {
+		out.append("+\n");
+	}
+	const char *s(out.c_str());
+	string::size_type len(out.size());
+	while(len != 0) {
+		ssize_t r(write(fd, s, len));
+		if(unlikely(r < 0)) {
+			if(errno == EINTR) {
+				continue;
+			}
+			_exit(EXIT_FAILURE);
+		}
+		s += r;
+		len -= static_cast<string::size_type>(r);
+	}
+	_exit(EXIT_SUCCESS);
+}
+
+/**
+Read the output of all workers in parallel
+**/
+static bool read_parts(vector<string> *outputs, const vector<int>& fds) {
+	vector<struct pollfd> polls(fds.size());
+	for(vector<int>::size_type i(0); likely(i != fds.size()); ++i) {
+		polls[i].fd = fds[i];
+		polls[i].events = POLLIN;
+	}
+	vector<int>::size_type open_fds(fds.size());
+	char buf[4096];
+	while(open_fds != 0) {
+		if(unlikely(poll(&(polls[0]), polls.size(), -1) < 0)) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		for(vector<int>::size_type i(0); likely(i != polls.size()); ++i) {
+			if((polls[i].fd < 0) || (polls[i].revents == 0)) {
+				continue;
+			}
+			ssize_t r(read(polls[i].fd, buf, sizeof(buf)));
+			if(r > 0) {
+				(*outputs)[i].append(buf, static_cast<string::size_type>(r));
+				continue;
+			}
+			if(unlikely(r < 0) && ((errno == EINTR) || (errno == EAGAIN))) {
+				continue;
+			}
+			if(unlikely(r < 0)) {
+				return false;
+			}
+			// End of file: Ignore this descriptor from now on
+			polls[i].fd = -1;
+			--open_fds;
+		}
+	}
+	return true;
+}
+
+/**
+The work of parallel_scan() which may leave the position of db anywhere
+**/
+ATTRIBUTE_NONNULL_ static bool scan_parts(PackageReader *reader, vector<Levenshtein> *distances, Database *db, const DBHeader& header, PortageSettings *ps, MatchTree *matchtree, unsigned int jobs) {
+	vector<PackageReader::Pins> parts;
+	if(!reader->split_categories(&parts, jobs) || (parts.size() <= 1)) {
+		return false;
+	}
+	vector<int> fds;
+	vector<pid_t> children;
+	bool success(true);
+	for(vector<PackageReader::Pins>::const_iterator it(parts.begin());
+		likely(it != parts.end()); ++it) {
+		int pipefd[2];
+		if(unlikely(pipe(pipefd) != 0)) {
+			success = false;
+			break;
+		}
+		pid_t child(fork());
+		if(unlikely(child == -1)) {
+			close(pipefd[0]);
+			close(pipefd[1]);
+			success = false;
+			break;
+		}
+		if(child == 0) {
+			close(pipefd[0]);
+			for(vector<int>::const_iterator fd(fds.begin()); likely(fd != fds.end()); ++fd) {
+				close(*fd);
+			}
+			scan_part(pipefd[1], db, header, ps, matchtree, *it);
+		}
+		close(pipefd[1]);
+		fds.PUSH_BACK(pipefd[0]);
+		children.PUSH_BACK(child);
+	}
+	vector<string> outputs(fds.size());
+	if(likely(success)) {
+		success = read_parts(&outputs, fds);
+	}
+	for(vector<int>::const_iterator fd(fds.begin()); likely(fd != fds.end()); ++fd) {
+		close(*fd);
+	}
+	for(vector<pid_t>::const_iterator child(children.begin());
+		likely(child != children.end()); ++child) {
+		int status;
+		pid_t r;
+		while(((r = waitpid(*child, &status, 0)) == -1) && (errno == EINTR)) {
+		}
+		if(unlikely(r != *child)) {
+			success = false;
+			continue;
+		}
+GCC_DIAG_OFF(old-style-cast)
+		if(!WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS)) {
+			success = false;
+		}
+GCC_DIAG_ON(old-style-cast)
+	}
+	if(unlikely(!success)) {
+		return false;
+	}
+	// The parts are in database order, so the pins are, too
+	PackageReader::Pins pins;
+	distances->clear();
+	for(vector<string>::const_iterator out(outputs.begin()); likely(out != outputs.end()); ++out) {
+		string::size_type start(0), end;
+		while((end = out->find('\n', start)) != string::npos) {
+			string::size_type space(out->find(' ', start));
+			string::size_type slash(out->find('/', start));
+			if(likely((space < slash) && (slash < end))) {
+				distances->PUSH_BACK(my_atou(out->substr(start, space - start).c_str()));
+				pins.PUSH_BACK(PackageReader::Pin(out->substr(space + 1, slash - space - 1),
+					out->substr(slash + 1, end - slash - 1)));
+			} else if(out->compare(start, end - start, "+") == 0) {
+				FuzzyAlgorithm::set_sort_by_levenshtein();
+			}
+			start = end + 1;
+		}
+	}
+	return reader->restrict_to(pins);
+}
+
+bool parallel_scan(PackageReader *reader, vector<Levenshtein> *distances, Database *db, const DBHeader& header, PortageSettings *ps, MatchTree *matchtree, unsigned int jobs) {
+	// With only one category, there is nothing to split
+	if((jobs <= 1) || (header.size <= 1) || !db->is_mapped()) {
+		return false;
+	}
+	// Reading the index moves the position of db
+	eix::OffsetType start(db->tell());
+	if(likely(scan_parts(reader, distances, db, header, ps, matchtree, jobs))) {
+		return true;
+	}
+	distances->clear();
+	string errtext;
+	if(unlikely(!db->seekabs(start, &errtext))) {
+		eix::say_error() % errtext;
+	}
+	return false;
+}
@@ -0,0 +1,39 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#ifndef SRC_SEARCH_PARALLEL_SCAN_H_
+#define SRC_SEARCH_PARALLEL_SCAN_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "search/levenshtein.h"
+
+class Database;
+class DBHeader;
+class MatchTree;
+class PackageReader;
+class PortageSettings;
+
+/**
+Let jobs processes match the packages of the cachefile in parallel, each
+for a part of the categories, and restrict reader to the packages which
+matched in one of them. These need not be matched again: distances gets
+the fuzzy distance of each of them (in the order of the reader), and
+FuzzyAlgorithm::sort_by_levenshtein() is set as if matched here.
+The workers are forked like in parallel_read(), so that the state which
+matching fills lazily (e.g. in PortageSettings or VarDbPkg) is not shared.
+The cachefile must have an index and be mapped into memory
+(otherwise, the processes would share the file position).
+@return false if nothing was done; reader and the position of db
+are unchanged then.
+**/
+ATTRIBUTE_NONNULL_ bool parallel_scan(PackageReader *reader, std::vector<Levenshtein> *distances, Database *db, const DBHeader& header, PortageSettings *ps, MatchTree *matchtree, unsigned int jobs);
+
+#endif  // SRC_SEARCH_PARALLEL_SCAN_H_
@@ -148,7 +148,9 @@ enum cli_options {
 	O_PROPERTIES_INTERACTIVE,
 	O_PROPERTIES_LIVE,
 	O_PROPERTIES_VIRTUAL,
-	O_PROPERTIES_SET
+	O_PROPERTIES_SET,
+	O_BATCH,
+	O_SERVER
 };
 
 
@@ -0,0 +1,354 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#include "various/server.h"
+#include <config.h>  // IWYU pragma: keep
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "eixTk/diagnostics.h"
+#include "eixTk/dialect.h"
+#include "eixTk/eixint.h"
+#include "eixTk/formated.h"
+#include "eixTk/i18n.h"
+#include "eixTk/inttypes.h"
+#include "eixTk/likely.h"
+#include "eixTk/null.h"
+#include "eixTk/stringtypes.h"
+#include "eixTk/utils.h"
+
+using std::string;
+
+/**
+The descriptors passed from the client to the server
+**/
+static const int passed_fds[] = { 0, 1, 2 };
+static const unsigned int passed_count = sizeof(passed_fds) / sizeof(int);
+
+ATTRIBUTE_NONNULL_ static bool set_address(struct sockaddr_un *addr, const char *path, string *errtext) {
+	std::memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	string::size_type len(std::strlen(path));
+	if(unlikely(len >= sizeof(addr->sun_path))) {
+		*errtext = eix::format(_("socket name %s is too long")) % path;
+		return false;
+	}
+	std::memcpy(addr->sun_path, path, len);
+	return true;
+}
+
+ATTRIBUTE_NONNULL_ static void set_errno_text(string *errtext, const char *text, const char *path) {
+	*errtext = eix::format(text) % path % std::strerror(errno);
+}
+
+int server_listen(const char *path, string *errtext) {
+	struct sockaddr_un addr;
+	if(unlikely(!set_address(&addr, path, errtext))) {
+		return -1;
+	}
+	struct stat st;
+	if((lstat(path, &st) == 0) && S_ISSOCK(st.st_mode)) {
+		unlink(path);
+	}
+	int fd(socket(AF_UNIX, SOCK_STREAM, 0));
+	if(unlikely(fd < 0)) {
+		set_errno_text(errtext, _("cannot create socket %s: %s"), path);
+		return -1;
+	}
+	// The socket must not be accessible by other users even for a moment
+	mode_t old_umask(umask(0077));
+GCC_DIAG_OFF(old-style-cast)
+	bool bound(bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0);
+GCC_DIAG_ON(old-style-cast)
+	umask(old_umask);
+	if(unlikely(!bound || (chmod(path, 0600) != 0) ||
+		(listen(fd, SOMAXCONN) != 0))) {
+		set_errno_text(errtext, _("cannot listen on socket %s: %s"), path);
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/**
+@return true if the client at conn runs as the same user as we do
+**/
+#ifdef SO_PEERCRED
+static bool same_user(int conn) {
+	struct ucred cred;
+	socklen_t len(sizeof(cred));
+	if(unlikely((getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0) ||
+		(len != sizeof(cred)))) {
+		return false;
+	}
+	return (cred.uid == getuid());
+}
+#else
+static bool same_user(int /* conn */) {
+	return true;
+}
+#endif
+
+int server_accept(int fd) {
+	for(;;) {
+		int conn(accept(fd, NULLPTR, NULLPTR));
+		if(likely(conn >= 0)) {
+			if(likely(same_user(conn))) {
+				return conn;
+			}
+			close(conn);
+			continue;
+		}
+		if((errno != EINTR) && (errno != ECONNABORTED)) {
+			return -1;
+		}
+	}
+}
+
+/**
+Write all of len bytes from s
+**/
+ATTRIBUTE_NONNULL_ static bool write_all(int fd, const char *s, string::size_type len) {
+	while(len != 0) {
+		ssize_t r(write(fd, s, len));
+		if(unlikely(r < 0)) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		s += r;
+		len -= static_cast<string::size_type>(r);
+	}
+	return true;
+}
+
+bool server_receive(int fd, string *dir, WordVec *args, string *errtext) {
+	char buf[4096];
+	struct iovec iov;
+	iov.iov_base = buf;
+	iov.iov_len = sizeof(buf);
+	union {
+		struct cmsghdr align;
+		char control[CMSG_SPACE(sizeof(passed_fds))];
+	} cmsg_buf;
+	struct msghdr msg;
+	std::memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cmsg_buf.control;
+	msg.msg_controllen = sizeof(cmsg_buf.control);
+	ssize_t r;
+	while(((r = recvmsg(fd, &msg, 0)) < 0) && (errno == EINTR)) {
+	}
+	if(unlikely(r <= 0)) {
+		*errtext = _("cannot receive request of client");
+		return false;
+	}
+	bool have_fds(false);
+GCC_DIAG_OFF(old-style-cast)
+	for(struct cmsghdr *cmsg(CMSG_FIRSTHDR(&msg)); cmsg != NULLPTR;
+		cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if((cmsg->cmsg_level != SOL_SOCKET) || (cmsg->cmsg_type != SCM_RIGHTS) ||
+			(cmsg->cmsg_len != CMSG_LEN(sizeof(passed_fds)))) {
+			continue;
+		}
+		int fds[passed_count];
+		std::memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+GCC_DIAG_ON(old-style-cast)
+		for(unsigned int i(0); likely(i != passed_count); ++i) {
+			dup2(fds[i], passed_fds[i]);
+			close(fds[i]);
+		}
+		have_fds = true;
+	}
+	if(unlikely(!have_fds)) {
+		*errtext = _("client did not pass its descriptors");
+		return false;
+	}
+	string request(buf, static_cast<string::size_type>(r));
+	while((r = read(fd, buf, sizeof(buf))) != 0) {
+		if(unlikely(r < 0)) {
+			if(errno == EINTR) {
+				continue;
+			}
+			*errtext = _("cannot receive request of client");
+			return false;
+		}
+		request.append(buf, static_cast<string::size_type>(r));
+	}
+	// The request is the directory and the arguments, each terminated by \0
+	if(unlikely(request.empty() || (request[request.size() - 1] != '\0'))) {
+		*errtext = _("invalid request of client");
+		return false;
+	}
+	string::size_type start(request.find('\0'));
+	dir->assign(request, 0, start);
+	args->clear();
+	for(string::size_type end; ++start != request.size(); start = end) {
+		end = request.find('\0', start);
+		args->PUSH_BACK(request.substr(start, end - start));
+	}
+	return true;
+}
+
+void server_reply(int fd, int status) {
+	char c(static_cast<char>(status));
+	write_all(fd, &c, 1);
+	close(fd);
+}
+
+bool run_client(const char *path, int argc, const char *const *argv, int *status, string *errtext) {
+	struct sockaddr_un addr;
+	if(unlikely(!set_address(&addr, path, errtext))) {
+		return false;
+	}
+	int fd(socket(AF_UNIX, SOCK_STREAM, 0));
+	if(unlikely(fd < 0)) {
+		set_errno_text(errtext, _("cannot create socket %s: %s"), path);
+		return false;
+	}
+GCC_DIAG_OFF(old-style-cast)
+	if(unlikely(connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)) {
+GCC_DIAG_ON(old-style-cast)
+		set_errno_text(errtext, _("cannot connect to server at %s: %s"), path);
+		close(fd);
+		return false;
+	}
+	string request;
+	char *cwd(getcwd(NULLPTR, 0));
+	if(likely(cwd != NULLPTR)) {
+		request.assign(cwd);
+		std::free(cwd);
+	}
+	request.append(1, '\0');
+	for(int i(0); likely(i < argc); ++i) {
+		request.append(argv[i]);
+		request.append(1, '\0');
+	}
+	struct iovec iov;
+	iov.iov_base = const_cast<char *>(request.c_str());
+	iov.iov_len = request.size();
+	union {
+		struct cmsghdr align;
+		char control[CMSG_SPACE(sizeof(passed_fds))];
+	} cmsg_buf;
+	std::memset(&cmsg_buf, 0, sizeof(cmsg_buf));
+	struct msghdr msg;
+	std::memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cmsg_buf.control;
+	msg.msg_controllen = sizeof(cmsg_buf.control);
+GCC_DIAG_OFF(old-style-cast)
+	struct cmsghdr *cmsg(CMSG_FIRSTHDR(&msg));
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(passed_fds));
+	std::memcpy(CMSG_DATA(cmsg), passed_fds, sizeof(passed_fds));
+GCC_DIAG_ON(old-style-cast)
+	ssize_t r;
+	while(((r = sendmsg(fd, &msg, 0)) < 0) && (errno == EINTR)) {
+	}
+	if(unlikely((r < 0) ||
+		!write_all(fd, request.c_str() + r, request.size() - static_cast<string::size_type>(r)))) {
+		set_errno_text(errtext, _("cannot send request to server at %s: %s"), path);
+		close(fd);
+		return false;
+	}
+	shutdown(fd, SHUT_WR);
+	// The server writes to our descriptors; we only wait for the status
+	char c;
+	while(((r = read(fd, &c, 1)) < 0) && (errno == EINTR)) {
+	}
+	close(fd);
+	*status = ((r == 1) ? static_cast<int>(static_cast<eix::UChar>(c)) : EXIT_FAILURE);
+	return true;
+}
+
+/**
+@return a hash of the content of the regular file name, or an empty string
+**/
+static string content_hash(const string& name) {
+	std::ifstream file(name.c_str(), std::ios::binary);
+	if(unlikely(!file.is_open())) {
+		return string();
+	}
+	// Two FNV-1a hashes with different offsets
+	uint32_t hash[2] = { 0x811c9dc5U, 0x050c5d1fU };
+	char buf[4096];
+	while(file.read(buf, sizeof(buf)) || (file.gcount() != 0)) {
+		std::streamsize len(file.gcount());
+		for(std::streamsize i(0); likely(i != len); ++i) {
+			for(unsigned int j(0); likely(j != 2); ++j) {
+				hash[j] ^= static_cast<eix::UChar>(buf[i]);
+				hash[j] *= 0x01000193U;
+			}
+		}
+	}
+	static const char hexdigits[] = "0123456789abcdef";
+	string result;
+	for(unsigned int j(0); likely(j != 2); ++j) {
+		for(int shift(28); likely(shift >= 0); shift -= 4) {
+			result.append(1, hexdigits[(hash[j] >> shift) & 0x0fU]);
+		}
+	}
+	return result;
+}
+
+void FileStamps::add(const string& name, unsigned int depth, bool contents, Visited *visited) {
+	Stamp stamp;
+	stamp.name = name;
+	struct stat st;
+	if(unlikely(stat(name.c_str(), &st) != 0)) {
+		stamp.mtime = 0;
+		stamp.size = 0;
+		stamp.inode = 0;
+		stamps.PUSH_BACK(stamp);
+		return;
+	}
+	stamp.mtime = st.st_mtime;
+	stamp.size = st.st_size;
+	stamp.inode = st.st_ino;
+	if(contents && S_ISREG(st.st_mode)) {
+		stamp.hash = content_hash(name);
+	}
+	stamps.PUSH_BACK(stamp);
+	if((depth == 0) || !S_ISDIR(st.st_mode) ||
+		!visited->INSERT(std::make_pair(st.st_dev, st.st_ino)).second) {
+		return;
+	}
+	WordVec entries;
+	if(unlikely(!pushback_files(name, &entries, NULLPTR, 0, false, false))) {
+		return;
+	}
+	string prefix(name);
+	prefix.append(1, '/');
+	for(WordVec::const_iterator it(entries.begin()); likely(it != entries.end()); ++it) {
+		add(prefix + *it, depth - 1, contents, visited);
+	}
+}
+
+void FileStamps::append_to(string *s) const {
+	for(std::vector<Stamp>::const_iterator it(stamps.begin());
+		likely(it != stamps.end()); ++it) {
+		s->append(eix::format("%s %s %s %s %s\n") % it->name % it->mtime % it->size % it->inode % it->hash);
+	}
+}
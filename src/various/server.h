@@ -0,0 +1,129 @@
+// vim:set noet cinoptions= sw=4 ts=4:
+// This file is part of the eix project and distributed under the
+// terms of the GNU General Public License v2.
+//
+// Copyright (c)
+//   agent <agent@local>
+
+#ifndef SRC_VARIOUS_SERVER_H_
+#define SRC_VARIOUS_SERVER_H_ 1
+
+#include <config.h>  // IWYU pragma: keep
+
+#include <sys/types.h>
+
+#include <ctime>
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "eixTk/attribute.h"
+#include "eixTk/stringtypes.h"
+
+/**
+Create the listening unix domain socket of eix --server.
+A stale socket at path is removed first; the new one has mode 0600.
+@return the descriptor or -1 (errtext is set then)
+**/
+ATTRIBUTE_NONNULL_ int server_listen(const char *path, std::string *errtext);
+
+/**
+Wait for the next client at the listening socket fd.
+Clients of other users are rejected if the system can tell.
+@return the connection or -1 in case of a fatal error
+**/
+int server_accept(int fd);
+
+/**
+Receive the request of the client connected at fd:
+The standard descriptors of the client replace ours,
+and its working directory and arguments are stored.
+**/
+ATTRIBUTE_NONNULL_ bool server_receive(int fd, std::string *dir, WordVec *args, std::string *errtext);
+
+/**
+Send the exit status to the client and close the connection
+**/
+void server_reply(int fd, int status);
+
+/**
+Forward the arguments (without program name), the working directory and
+the standard descriptors to the server listening at path and wait for
+the exit status of the query. The server writes directly to our descriptors.
+@return false if the server could not be contacted (errtext is set then)
+**/
+ATTRIBUTE_NONNULL_ bool run_client(const char *path, int argc, const char *const *argv, int *status, std::string *errtext);
+
+/**
+The modification stamps of some files and directory trees.
+A server compares them to notice that its data has become stale.
+**/
+class FileStamps {
+	private:
+		class Stamp {
+			public:
+				std::string name;
+				std::time_t mtime;
+				off_t size;
+				ino_t inode;
+				// Of the content if requested, so that also changes in the
+				// same second with the same size are noticed
+				std::string hash;
+
+				bool operator==(const Stamp& s) const {
+					return ((mtime == s.mtime) && (size == s.size) &&
+						(inode == s.inode) && (name == s.name) && (hash == s.hash));
+				}
+		};
+		std::vector<Stamp> stamps;
+
+		/**
+		The directories (device, inode) entered so far, to cut cyclic links
+		**/
+		typedef std::set<std::pair<dev_t, ino_t> > Visited;
+
+		ATTRIBUTE_NONNULL_ void add(const std::string& name, unsigned int depth, bool contents, Visited *visited);
+
+	public:
+		/**
+		Add the stamp of a file or directory; of a directory also the
+		stamps of its entries up to the given depth.
+		Symbolic links (also to directories) are followed.
+		A missing file is recorded, too, so that its creation is noticed.
+		**/
+		void add(const std::string& name, unsigned int depth) {
+			Visited visited;
+			add(name, depth, false, &visited);
+		}
+
+		/**
+		Add the stamps of a whole directory tree (or of a file).
+		Each directory is entered only once, so that cyclic links end.
+		@param contents also stamp the content of the regular files
+		**/
+		void add_tree(const std::string& name, bool contents) {
+			Visited visited;
+			add(name, static_cast<unsigned int>(-1), contents, &visited);
+		}
+
+		void clear() {
+			stamps.clear();
+		}
+
+		/**
+		Append a textual form of the stamps to s
+		**/
+		ATTRIBUTE_NONNULL_ void append_to(std::string *s) const;
+
+		bool operator==(const FileStamps& s) const {
+			return (stamps == s.stamps);
+		}
+
+		bool operator!=(const FileStamps& s) const {
+			return !(stamps == s.stamps);
+		}
+};
+
+#endif  // SRC_VARIOUS_SERVER_H_